@@ -0,0 +1,118 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+
+#include "../src/Lexer.h"
+#include "../src/Parser.h"
+
+// Lexes and parses generated sources of doubling size and fails when the time per line grows by more than
+// maximumSlowdown from the smallest to the largest, so a front end that stops scaling linearly shows up.
+// The sources go far past 64 KiB and 65,535 tokens, and the instruction count is checked against the
+// generated one, so positions or lines that wrap show up as well
+
+static constexpr unsigned sizeSteps = 4;
+static constexpr unsigned repetitions = 3;
+static constexpr double maximumSlowdown = 2.0;
+
+// Each block is five lines: a label, three instructions and a data definition
+static constexpr size_t blockLines = 5;
+static constexpr size_t blockInstructions = 5;
+
+static std::string generateSource(size_t blocks)
+{
+	std::string source;
+	source.reserve(blocks * 110);
+
+	for (size_t i = 0; i < blocks; i++)
+	{
+		std::string label = "label" + std::to_string(i);
+		source += label + ":\n";
+		source += "\tmov ax, [bx + si + " + std::to_string(i % 128) + "]\n";
+		source += "\tadd ax, " + std::to_string(i % 30000) + " * 2\n";
+		source += "\tjmp " + label + "\n";
+		source += "\tdb 'table entry', " + std::to_string(i % 256) + "\n";
+	}
+	return source;
+}
+
+struct PhaseTimes
+{
+	double lexing;
+	double parsing;
+	size_t tokens;
+	size_t instructions;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static PhaseTimes measure(const std::string& source, unsigned threadCount)
+{
+	PhaseTimes best{ 1e30, 1e30, 0, 0 };
+
+	for (unsigned i = 0; i < repetitions; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		Lexer lexer(source);
+		TokenStream& tokens = lexer.tokenize(threadCount);
+		double lexing = secondsSince(start);
+
+		start = std::chrono::steady_clock::now();
+		ParseArena arena;
+		Parser parser(tokens, arena);
+		std::vector<Instruction>& instructions = parser.parse();
+		double parsing = secondsSince(start);
+
+		best = { std::min(best.lexing, lexing), std::min(best.parsing, parsing), tokens.size() - 1, instructions.size() };
+	}
+	return best;
+}
+
+int main(int argc, char** argv)
+{
+	std::ios::sync_with_stdio(false);
+
+	size_t baseLines = argc > 1 ? (size_t)std::max(std::atoll(argv[1]), 1000ll) : 250000;
+	unsigned threadCount = argc > 2 ? (unsigned)std::max(std::atoi(argv[2]), 1) : std::thread::hardware_concurrency();
+
+	double firstLexing = 0;
+	double firstParsing = 0;
+	bool failed = false;
+
+	std::cout << "lines\tbytes\ttokens\tlex ns/line\tparse ns/line" << '\n';
+	for (unsigned step = 0; step < sizeSteps; step++)
+	{
+		size_t blocks = (baseLines << step) / blockLines;
+		std::string source = generateSource(blocks);
+		size_t lines = blocks * blockLines;
+
+		PhaseTimes times = measure(source, threadCount);
+		double lexing = times.lexing * 1e9 / lines;
+		double parsing = times.parsing * 1e9 / lines;
+		std::cout << lines << '\t' << source.size() << '\t' << times.tokens << '\t' << lexing << '\t' << parsing << '\n';
+
+		if (times.instructions != blocks * blockInstructions)
+		{
+			std::cout << "Expected " << blocks * blockInstructions << " instructions, got " << times.instructions << '\n';
+			failed = true;
+		}
+
+		if (step == 0)
+		{
+			firstLexing = lexing;
+			firstParsing = parsing;
+		}
+		else if (step == sizeSteps - 1 && (lexing > firstLexing * maximumSlowdown || parsing > firstParsing * maximumSlowdown))
+		{
+			std::cout << "Time per line grew more than " << maximumSlowdown << "x, the front end no longer scales linearly" << '\n';
+			failed = true;
+		}
+	}
+
+	return failed ? 1 : 0;
+}
@@ -1,807 +1,967 @@
+#include <iostream>
+#include <algorithm>
+#include <cstring>
 
 #include "CodeGenerator.h"
-#include "instructionsSet.h"
 #include "getNumberSize.h"
+#include "parallelFor.h"
 #include "Parser.h"
 
-CodeGenerator::CodeGenerator(std::vector<Instruction>& instructions)
-:instructions(instructions)
+CodeGenerator::CodeGenerator(InstructionSpan instructions, const ParseArena& arena, const SymbolTable& symbols, unsigned threadCount, bool optimizesSize)
+:instructions(instructions), arena(&arena), symbols(symbols), threadCount(threadCount), optimizesSize(optimizesSize), labels(symbols.size())
 {
 }
 
-std::stringstream& CodeGenerator::generate()
+CodeGenerator::CodeGenerator(const SymbolTable& symbols, bool optimizesSize)
+:symbols(symbols), optimizesSize(optimizesSize)
 {
-	encodeInstructions();
+}
+
+bool CodeGenerator::hasLabelsNotFound() const
+{
+	return labelsNotFound;
+}
+
+std::vector<uint8_t>& CodeGenerator::generate()
+{
+	encodeInstructions(instructions, true);
+	patchLabels();
 
+	output.resize(initializedEnd);
 	return output;
 }
 
-void CodeGenerator::encodeInstructions()
+// Encodes batches as the parser thread sends them. The output and the references to labels of later batches
+// stay in memory until the empty batch arrives, since those can only be patched then. Jumps to such labels
+// are made near, as how far they go is not known yet
+std::vector<uint8_t>& CodeGenerator::generate(SpscQueue<ParseBatch>& queue)
 {
-	for (const auto& instruction : instructions)
+	for (ParseBatch batch = queue.pop(); !batch.instructions.empty(); batch = queue.pop())
 	{
-		instructionAddress = address;
-		if (instruction.token.type == TokenType::INSTRUCTION)
-		{
-			encodeInstruction(instruction);
-		}
-		else if (instruction.token.type == TokenType::DATA_DEFINING_INSTRUCTION)
+		arena = &batch.arena;
+		encodeInstructions(batch.instructions, false);
+	}
+	arena = nullptr;
+
+	patchLabels();
+
+	output.resize(initializedEnd);
+	return output;
+}
+
+// Encoding runs in two phases over chunks of instructions. First every chunk is measured in parallel, chunks after
+// the first without knowing their start address. Placing them is then a prefix sum over the chunk sizes, and only
+// a chunk that ran into something depending on its address is measured again, now that it is known. Measuring
+// repeats while branch relaxation grows jumps. With every label defined, the chunks are finally encoded in parallel
+// into their own slices of the output. isComplete tells that no batch follows with labels still to be defined
+void CodeGenerator::encodeInstructions(InstructionSpan instructions, bool isComplete)
+{
+	size_t chunkCount = threadCount < 2 ? 1 : std::clamp<size_t>(instructions.size() / minimumChunkSize, 1, (size_t)threadCount * 4);
+
+	std::vector<EncodingChunk> chunks(chunkCount);
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		chunks[i].first = instructions.size() * i / chunkCount;
+		chunks[i].last = instructions.size() * (i + 1) / chunkCount;
+	}
+
+	EncodingPosition start = position;
+	do
+	{
+		position = start;
+		measureChunks(instructions, chunks);
+	}
+	while (relaxBranches(instructions, start.instruction, chunks, isComplete));
+
+	output.resize(position.offset);
+
+	parallelFor(chunkCount, threadCount, [&](size_t i)
+	{
+		encodeChunk(instructions, chunks[i]);
+	});
+
+	for (const auto& chunk : chunks)
+	{
+		labelsToPatch.insert(labelsToPatch.end(), chunk.labelsToPatch.begin(), chunk.labelsToPatch.end());
+		initializedEnd = std::max(initializedEnd, chunk.initializedEnd);
+	}
+}
+
+// Measures and places the chunks from position on, defining their labels. Every relaxation round defines the labels
+// of these instructions again, the first declaration still wins
+void CodeGenerator::measureChunks(InstructionSpan instructions, std::vector<EncodingChunk>& chunks)
+{
+	uint32_t firstInstruction = position.instruction;
+
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		chunks[i].start = i == 0 ? position : EncodingPosition{ 0, firstInstruction + (uint32_t)chunks[i].first, 0, 0, 0, false, false };
+	}
+
+	parallelFor(chunks.size(), threadCount, [&](size_t i)
+	{
+		chunks[i].isMeasured = measureChunk(instructions, chunks[i]);
+	});
+
+	for (auto& chunk : chunks)
+	{
+		if (!chunk.isMeasured)
 		{
-			defineDataInstruction(instruction);
+			chunk.start = position;
+			measureChunk(instructions, chunk);
 		}
-		else if (instruction.token.type == TokenType::LOCAL_LABEL_DECLARATION) 
+		else if (!chunk.start.isPlaced)
 		{
-			patchLabel(currentLabel + instruction.token.stringValue);
-			labels.insert({ currentLabel + instruction.token.stringValue, { LabelType::ADDRESS_LABEL, address } });
+			placeChunk(chunk, position);
 		}
-		else if (instruction.token.type == TokenType::GLOBAL_LABEL_DECLARATION || instruction.token.type == TokenType::DATA_LABEL_DECLARATION)
+
+		for (const auto& declaration : chunk.labels)
 		{
-			patchLabel(instruction.token.stringValue);
-			labels.insert({ instruction.token.stringValue, { LabelType::ADDRESS_LABEL, address } });
+			Label& label = getLabel(declaration.symbol);
+			if (!label.defined || (label.instruction >= firstInstruction && declaration.instruction <= label.instruction))
+			{
+				label = { LabelType::ADDRESS_LABEL, declaration.address, true, declaration.instruction };
+			}
 		}
-	}
-	for (const auto& [labelToPatch, _] : labelsToPatch) 
-	{
-		std::cout << (labelToPatch  + ": not found") << '\n';
+		position = chunk.position;
 	}
 }
 
-void CodeGenerator::encodeInstruction(const Instruction& instruction)
+// Whether a 16-bit value, a rel8 displacement or an immediate of 0x83, survives as a sign-extended byte
+static bool isSignExtendedByte(int64_t number)
 {
-	if (instruction.token.stringValue == "org")
-	{
-		orgInstruction(instruction);
-	} 
-	else
+	return getNumberSize((int16_t)number) == 1;
+}
+
+// Makes the short jumps whose target is out of rel8 range near and returns whether any grew. Jumps never shrink,
+// so measuring again until none grows settles on the smallest code. jmp_short keeps its form and has to reach
+bool CodeGenerator::relaxBranches(InstructionSpan instructions, uint32_t firstInstruction, const std::vector<EncodingChunk>& chunks, bool isComplete) const
+{
+	bool hasGrown = false;
+	for (const auto& chunk : chunks)
 	{
-		switch (instruction.arguments.size())
+		for (const auto& branch : chunk.branches)
 		{
-			case 0: 
-			{
-				noOperandsInstruction(instruction);
-				break;
-			}
-			case 1: 
+			Instruction& instruction = instructions[branch.instruction - firstInstruction];
+			bool isFixed = instruction.mnemonic == jmpShortMnemonic;
+
+			if (const Label& label = findLabel(branch.label); label.defined ? isSignExtendedByte(label.address - branch.address) : isComplete || isFixed)
 			{
-				switch (instruction.arguments.at(0).token.type) 
-				{
-					case TokenType::REGISTER:
-					case TokenType::SEGMENT_REGISTER:
-					{
-						registerInstruction(instruction);
-						break;
-					}
-					case TokenType::NUMBER: 
-					{
-						numberInstruction(instruction);
-						break;
-					}
-					case TokenType::ARITHMETIC_BINARY_OPERATOR:
-					case TokenType::ARITHMETIC_UNARY_OPERATOR: 
-					case TokenType::GETSTARTADDRESS_OPERATOR:
-					case TokenType::GETCURRENTADDRESS_OPERATOR:
-					case TokenType::GETPROGRAMSIZE_OPERATOR:
-					{
-						resolveGetaddressOperators((Node*)&instruction.arguments.at(0));
-						numberInstruction(instruction);
-						break;
-					}
-					case TokenType::LOCAL_LABEL:
-					{
-						labelInstruction(instruction, currentLabel + instruction.arguments.at(0).token.stringValue);
-						break;
-					}
-					case TokenType::GLOBAL_LABEL:
-					{
-						labelInstruction(instruction, instruction.arguments.at(0).token.stringValue);
-						break;
-					}
-				}
-				break;
+				continue;
 			}
-			case 2: 
+			if (isFixed)
 			{
-				if (instruction.arguments.at(0).token.type == TokenType::REGISTER && instruction.arguments.at(1).token.type == TokenType::REGISTER) 
-				{
-					RegisterAndRegisterInstruction(instruction, "G", "G");
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::REGISTER && instruction.arguments.at(1).token.type == TokenType::SEGMENT_REGISTER)
-				{
-					RegisterAndRegisterInstruction(instruction, "G", "S");
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::SEGMENT_REGISTER && instruction.arguments.at(1).token.type == TokenType::REGISTER)
-				{
-					RegisterAndRegisterInstruction(instruction, "S", "G");
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::REGISTER && instruction.arguments.at(1).token.type == TokenType::NUMBER) 
-				{
-					GPRAndNumberInstruction(instruction);
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::REGISTER && instruction.arguments.at(1).token.type == TokenType::GETOFFSET_OPERATOR)
-				{
-					switch (instruction.arguments.at(1).right->token.type)
-					{
-						case TokenType::LOCAL_LABEL: 
-						{
-							GPRAndOffsetInstruction(instruction, currentLabel + instruction.arguments.at(1).right->token.stringValue);
-							break;
-						}
-						case TokenType::GLOBAL_LABEL:
-						{
-							GPRAndOffsetInstruction(instruction, instruction.arguments.at(1).right->token.stringValue);
-							break;
-						}
-					}
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::REGISTER && instruction.arguments.at(1).token.type == TokenType::MEMORY_ADDRESSING)
-				{
-					RegisterAndMemoryAddressingInstruction(instruction, "G", "M");
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::MEMORY_ADDRESSING && instruction.arguments.at(1).token.type == TokenType::REGISTER)
-				{
-					MemoryAddressingAndRegisterInstruction(instruction, "M", "G");
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::MEMORY_ADDRESSING && instruction.arguments.at(1).token.type == TokenType::NUMBER)
-				{
-					MemoryAddressingAndNumberInstruction(instruction);
-				}
-				else if (instruction.arguments.at(0).token.type == TokenType::SEGMENT_REGISTER && instruction.arguments.at(1).token.type == TokenType::MEMORY_ADDRESSING)
-				{
-					RegisterAndMemoryAddressingInstruction(instruction, "S", "M");
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::MEMORY_ADDRESSING && instruction.arguments.at(1).token.type == TokenType::SEGMENT_REGISTER)
-				{
-					RegisterAndMemoryAddressingInstruction(instruction, "M", "S");
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::REGISTER && instruction.arguments.at(1).token.type == TokenType::GLOBAL_LABEL)
-				{
-					RegisterAndLabelInstruction(instruction, "G", "M",instruction.arguments.at(1).token.stringValue);
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::REGISTER && instruction.arguments.at(1).token.type == TokenType::LOCAL_LABEL)
-				{
-					RegisterAndLabelInstruction(instruction, "G", "M", currentLabel + instruction.arguments.at(1).token.stringValue);
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::GLOBAL_LABEL && instruction.arguments.at(1).token.type == TokenType::REGISTER)
-				{
-					LabelAndRegisterInstruction(instruction, "M", "G", instruction.arguments.at(0).token.stringValue);
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::LOCAL_LABEL && instruction.arguments.at(1).token.type == TokenType::REGISTER)
-				{
-					LabelAndRegisterInstruction(instruction, "M", "G", currentLabel + instruction.arguments.at(1).token.stringValue);
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::SEGMENT_REGISTER && instruction.arguments.at(1).token.type == TokenType::GLOBAL_LABEL)
-				{
-					RegisterAndLabelInstruction(instruction, "S", "M", instruction.arguments.at(1).token.stringValue);
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::SEGMENT_REGISTER && instruction.arguments.at(1).token.type == TokenType::LOCAL_LABEL)
-				{
-					RegisterAndLabelInstruction(instruction, "S", "M", currentLabel + instruction.arguments.at(1).token.stringValue);
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::GLOBAL_LABEL && instruction.arguments.at(1).token.type == TokenType::SEGMENT_REGISTER)
-				{
-					LabelAndRegisterInstruction(instruction, "M", "S", instruction.arguments.at(0).token.stringValue);
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::LOCAL_LABEL && instruction.arguments.at(1).token.type == TokenType::SEGMENT_REGISTER)
-				{
-					LabelAndRegisterInstruction(instruction, "M", "S", currentLabel + instruction.arguments.at(0).token.stringValue);
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::GLOBAL_LABEL && instruction.arguments.at(1).token.type == TokenType::NUMBER)
-				{
-					LabelAndNumberInstruction(instruction, instruction.arguments.at(0).token.stringValue);
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::LOCAL_LABEL && instruction.arguments.at(1).token.type == TokenType::NUMBER)
-				{
-					LabelAndNumberInstruction(instruction, currentLabel + instruction.arguments.at(0).token.stringValue);
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::GLOBAL_LABEL && instruction.arguments.at(1).token.type == TokenType::NUMBER)
-				{
-					LabelAndNumberInstruction(instruction, instruction.arguments.at(0).token.stringValue);
-				}
-
-				else if (instruction.arguments.at(0).token.type == TokenType::GLOBAL_LABEL && instruction.arguments.at(1).token.type == TokenType::GETOFFSET_OPERATOR)
-				{
-					switch (instruction.arguments.at(1).right->token.type)
-					{
-						case TokenType::LOCAL_LABEL:
-						{
-							LabelAndOffsetInstruction(instruction, instruction.arguments.at(0).token.stringValue, currentLabel + instruction.arguments.at(1).right->token.stringValue);
-							break;
-						}
-						case TokenType::GLOBAL_LABEL:
-						{
-							LabelAndOffsetInstruction(instruction, instruction.arguments.at(0).token.stringValue, instruction.arguments.at(1).right->token.stringValue);
-							break;
-						}
-					}
-				}
-				else if (instruction.arguments.at(0).token.type == TokenType::GLOBAL_LABEL && instruction.arguments.at(1).token.type == TokenType::GETOFFSET_OPERATOR)
-				{
-					switch (instruction.arguments.at(1).right->token.type)
-					{
-						case TokenType::LOCAL_LABEL:
-						{
-							LabelAndOffsetInstruction(instruction, currentLabel + instruction.arguments.at(0).token.stringValue, currentLabel + instruction.arguments.at(1).right->token.stringValue);
-							break;
-						}
-						case TokenType::GLOBAL_LABEL:
-						{
-							LabelAndOffsetInstruction(instruction, currentLabel + instruction.arguments.at(0).token.stringValue, instruction.arguments.at(1).right->token.stringValue);
-							break;
-						}
-					}
-				}
-				else 
-				{
-					error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
-				}
-				break;
-			}       
-			default: 
-			{
-				error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
-				break;
+				error(instruction.line, "Jump target out of range");
 			}
+			instruction.size = 2;
+			hasGrown = true;
 		}
 	}
+	return hasGrown;
 }
 
-void CodeGenerator::resolveGetaddressOperators(Node *node)
+// Moves a chunk measured from an unknown start to placed
+void CodeGenerator::placeChunk(EncodingChunk& chunk, const EncodingPosition& placed)
 {
-	if (!node) 
+	for (auto& declaration : chunk.labels)
 	{
-		return;
+		if (!declaration.isAbsolute)
+		{
+			declaration.address += placed.address;
+		}
 	}
-	switch(node->token.type)
+	for (auto& branch : chunk.branches)
 	{
-		case TokenType::NONE: 
+		if (!branch.isAbsolute)
 		{
-			return;
+			branch.address += placed.address;
 		}
-		case TokenType::GETCURRENTADDRESS_OPERATOR: 
+	}
+
+	chunk.position.offset += placed.offset;
+	if (!chunk.position.isAbsolute)
+	{
+		chunk.position.address += placed.address;
+		chunk.position.startAddress = placed.startAddress;
+	}
+	chunk.position.isPlaced = true;
+	chunk.position.isAbsolute = true;
+
+	chunk.start = placed;
+}
+
+// Returns false when the chunk needs its start address or holds an error. A placed chunk reports errors right away,
+// every chunk before it has been measured without any
+bool CodeGenerator::measureChunk(InstructionSpan instructions, EncodingChunk& chunk) const
+{
+	chunk.position = chunk.start;
+	chunk.labels.clear();
+	chunk.branches.clear();
+
+	for (size_t i = chunk.first; i < chunk.last; i++, chunk.position.instruction++)
+	{
+		const Instruction& instruction = instructions[i];
+		chunk.position.instructionAddress = chunk.position.address;
+
+		if (instruction.type == TokenType::INSTRUCTION)
 		{
-			node->token.type = TokenType::NUMBER;
-			node->token.numberValue = instructionAddress;
-			break;
+			if (!measureInstruction(instruction, chunk))
+			{
+				return false;
+			}
 		}
-		case TokenType::GETSTARTADDRESS_OPERATOR: 
+		else if (instruction.type == TokenType::DATA_DEFINING_INSTRUCTION)
 		{
-			node->token.type = TokenType::NUMBER;
-			node->token.numberValue = startAddress;
-			break;
-		}
-		case TokenType::GETPROGRAMSIZE_OPERATOR: {
-			node->token.type = TokenType::NUMBER;
-			node->token.numberValue = instructionAddress - startAddress;
-			break;
+			if (!measureData(instruction, chunk))
+			{
+				return false;
+			}
 		}
-		default: 
+		else if (instruction.type == TokenType::LOCAL_LABEL_DECLARATION || instruction.type == TokenType::GLOBAL_LABEL_DECLARATION || instruction.type == TokenType::DATA_LABEL_DECLARATION)
 		{
-			break;
+			chunk.labels.push_back({ instruction.symbol, chunk.position.instruction, chunk.position.address, chunk.position.isAbsolute });
 		}
 	}
-	resolveGetaddressOperators(node->left.get());
-	resolveGetaddressOperators(node->right.get());
+	return true;
 }
 
-void CodeGenerator::patchLabel(const std::string& label)
+void CodeGenerator::encodeChunk(InstructionSpan instructions, EncodingChunk& chunk)
 {
-	auto range = labelsToPatch.equal_range(label);
-	std::multimap<std::string, LabelToPatch>::iterator it = range.first;
-	while (it != range.second)
+	chunk.position = chunk.start;
+
+	for (size_t i = chunk.first; i < chunk.last; i++, chunk.position.instruction++)
 	{
-		output.seekp(it->second.outputAddress - startAddress);
-		streamNumber(address - it->second.relativeTo, it->second.size);
-		output.seekp(0, output.end);
-		it = labelsToPatch.erase(it);
+		const Instruction& instruction = instructions[i];
+		chunk.position.instructionAddress = chunk.position.address;
+		size_t offset = chunk.position.offset;
+
+		if (instruction.type == TokenType::INSTRUCTION)
+		{
+			encodeInstruction(instruction, chunk);
+		}
+		else if (instruction.type == TokenType::DATA_DEFINING_INSTRUCTION)
+		{
+			defineDataInstruction(instruction, chunk);
+			if (dataDefiningInstructions[instruction.mnemonic].kind == DataDefinitionKind::RESERVATION)
+			{
+				continue;
+			}
+		}
+		if (chunk.position.offset != offset)
+		{
+			chunk.initializedEnd = chunk.position.offset;
+		}
 	}
 }
 
-Node* CodeGenerator::findNumber(Node* node)
+bool CodeGenerator::measureInstruction(const Instruction& instruction, EncodingChunk& chunk) const
 {
-	if (!node || node->token.type == TokenType::NUMBER)
+	if (instruction.mnemonic == orgMnemonic)
 	{
-		return node;
+		orgInstruction(instruction, chunk.position);
+		return true;
 	}
-
-	Node* left = findNumber(node->left.get());
-	if (left) 
+	if (instruction.operandCount > 2)
 	{
-		return left;
+		return measureInvalidOperands(instruction, chunk);
 	}
 
-	Node* right = findNumber(node->right.get());
-	if (right) 
-	{
-		return right;
-	}
+	OperandForm formA = instruction.operandCount > 0 ? getOperandForm(instruction.operands[0]) : OperandForm::NONE;
+	OperandForm formB = instruction.operandCount > 1 ? getOperandForm(instruction.operands[1]) : OperandForm::NONE;
 
-	return nullptr;
+	return (this->*encoders[(size_t)formA][(size_t)formB].measure)(instruction, chunk);
 }
 
-void CodeGenerator::orgInstruction(const Instruction& instruction)
+// A negative repeat count emits nothing but still moves the address back, as it always has
+bool CodeGenerator::measureData(const Instruction& instruction, EncodingChunk& chunk) const
 {
-	startAddress = instruction.arguments.at(0).token.numberValue;
-	address = startAddress;
-}
-
-void CodeGenerator::defineDataInstruction(const Instruction& instruction)
-{
-	for (auto& argument : instruction.arguments)
+	for (const DataItem* item = arena->dataBegin(instruction.data); item != arena->dataEnd(instruction.data); item++)
 	{
-		if (argument.token.type == TokenType::NUMBER)
+		if (item->type == TokenType::NUMBER)
+		{
+			chunk.position.offset += instruction.size;
+			chunk.position.address += instruction.size;
+		}
+		else if (item->type == TokenType::STRING)
 		{
-			streamNumber(argument.token.numberValue, instruction.token.size);
-			address += instruction.token.size;
+			chunk.position.offset += (size_t)instruction.size * item->string.size;
+			chunk.position.address += instruction.size * item->string.size;
 		}
-		else if (argument.token.type == TokenType::DUPDATA_OPERATOR) 
+		else if (item->type == TokenType::DUPDATA_OPERATOR)
 		{
-			resolveGetaddressOperators(argument.left.get());
-			resolveGetaddressOperators(argument.right.get());
-			Node amount = Parser::performArithmeticOperations(*argument.left.get());
-			Node data = Parser::performArithmeticOperations(*argument.right.get());
-			for (int i = 0; i < amount.token.numberValue; i++) 
+			int64_t amount = 0;
+			if (!tryEvaluate(item->dup.amount, item->line, chunk, &amount) || !tryEvaluate(item->dup.value, item->line, chunk))
 			{
-				streamNumber(data.token.numberValue, instruction.token.size);
+				return false;
 			}
-			address += instruction.token.size * amount.token.numberValue;
+			chunk.position.offset += amount > 0 ? (size_t)(instruction.size * amount) : 0;
+			chunk.position.address += instruction.size * amount;
 		}
-		else 
+		else
 		{
-			error(argument.token.line, instruction.token.stringValue + ": data expected");
+			if (chunk.position.isPlaced)
+			{
+				error(item->line, std::string(dataDefiningInstructions[instruction.mnemonic].name) + ": data expected");
+			}
+			return false;
 		}
 	}
+	return true;
 }
 
-void CodeGenerator::noOperandsInstruction(const Instruction& instruction)
+// Expressions that can fail are tried while measuring, so encoding never runs into an error. value asks for the result
+bool CodeGenerator::tryEvaluate(uint32_t expression, uint32_t line, const EncodingChunk& chunk, int64_t* value) const
 {
-	if (const auto [opcode, _] = getInstructionOpcode(instruction.token.stringValue, "", "", 0, 0, true, true); opcode != -1)
-	{   
-		output << (uint8_t)opcode;
+	const ExpressionCode* begin = arena->expressionBegin(expression);
+	const ExpressionCode* end = arena->expressionEnd(expression);
 
-		address += 1;
+	if (!value && !mayFail(begin, end))
+	{
+		return true;
 	}
-	else
+	if (!chunk.position.isAbsolute && usesAddress(begin, end))
 	{
-		error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
+		return false;
 	}
-}
 
-void CodeGenerator::registerInstruction(const Instruction& instruction)
-{
-	if (const auto [opcode, _] = getInstructionOpcode(instruction.token.stringValue, instruction.arguments.at(0).token.stringValue, "", (uint8_t*)&instruction.arguments.at(0).token.size, 0, true, true); opcode != -1)
+	int64_t result = 0;
+	if (chunk.position.isPlaced)
 	{
-		output << (uint8_t)opcode;
-
-		address += 1;
+		result = evaluate(expression, line, chunk.position);
 	}
-	else
+	else if (tryEvaluateExpression(begin, end, { chunk.position.instructionAddress, chunk.position.startAddress }, result) != ExpressionError::NONE)
+	{
+		return false;
+	}
+
+	if (value)
 	{
-		error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
+		*value = result;
 	}
+	return true;
 }
 
-void CodeGenerator::numberInstruction(const Instruction& instruction)
+void CodeGenerator::encodeInstruction(const Instruction& instruction, EncodingChunk& chunk)
 {
-	if (const auto [opcode, _] = getInstructionOpcode(instruction.token.stringValue, "I", "", (uint8_t*)&instruction.arguments.at(0).token.size, 0, false, false); opcode != -1)
+	if (instruction.mnemonic == orgMnemonic)
 	{
-		output << (uint8_t)opcode;
-
-		address += 1;
-
-		streamNumber(instruction.arguments.at(0).token.numberValue, instruction.arguments.at(0).token.size);
-
-		address += instruction.arguments.at(0).token.size;
+		orgInstruction(instruction, chunk.position);
+	} 
+	else if (instruction.operandCount > 2)
+	{
+		invalidOperands(instruction);
 	}
 	else
 	{
-		error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
+		OperandForm formA = instruction.operandCount > 0 ? getOperandForm(instruction.operands[0]) : OperandForm::NONE;
+		OperandForm formB = instruction.operandCount > 1 ? getOperandForm(instruction.operands[1]) : OperandForm::NONE;
+
+		(this->*encoders[(size_t)formA][(size_t)formB].encode)(instruction, chunk);
 	}
 }
 
-void CodeGenerator::labelInstruction(const Instruction& instruction, const std::string &label)
+BranchType CodeGenerator::getBranchType(const Instruction& instruction, const Opcode& opcode)
 {
-	uint8_t offsetSize = 1;
-	if (const auto [opcode, _] = getInstructionOpcode(instruction.token.stringValue, "J", "", &offsetSize, 0, false, false); opcode != -1)
+	if (instruction.mnemonic == jmpMnemonic)
 	{
-		output << (uint8_t)opcode;
-
-		address += 1;
-
-		address += offsetSize;
-
-		if (const auto& it = labels.find(label); it != labels.end())
-		{
-			streamNumber(it->second.address - address, offsetSize);
-		}
-		else
-		{
-			streamNumber(0, offsetSize);
-			labelsToPatch.insert({ label, { (uint16_t)(address - offsetSize), address, offsetSize } });
-		}
+		return BranchType::JUMP;
 	}
-	else
+	if (instruction.mnemonic == jmpShortMnemonic)
 	{
-		error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
+		return BranchType::SHORT;
 	}
+	// Jcc rel8 take 70h to 7Fh, the low bit inverts the condition
+	return (opcode.opcode & 0xF0) == 0x70 ? BranchType::CONDITIONAL : BranchType::FIXED;
 }
 
-void CodeGenerator::RegisterAndRegisterInstruction(const Instruction& instruction, const std::string& operandA, const std::string& operandB)
+// Jumps are measured short until relaxBranches makes them near. call has no short form on the 8086
+bool CodeGenerator::measureBranch(const Instruction& instruction, const Encoding& encoding, EncodingChunk& chunk) const
 {
-	if (const auto [opcode, _] = getInstructionOpcode(instruction.token.stringValue, operandA, operandB, (uint8_t*)&instruction.arguments.at(0).token.size, (uint8_t*)&instruction.arguments.at(1).token.size, true, true); opcode != -1)
-	{
-		output << (uint8_t)opcode;
-
-		address += 1;
-
-		AddresingMode addressingMode = { 0b11, instruction.arguments.at(0).token.numberValue, instruction.arguments.at(1).token.numberValue };
+	BranchType type = getBranchType(instruction, *encoding.opcode);
+	bool isNear = instruction.size == 2;
 
-		output << addressingMode.to_uint8t();
+	uint16_t size = type == BranchType::FIXED ? 1 + encoding.sizes[0] : !isNear ? 2 : type == BranchType::JUMP ? 3 : 5;
+	chunk.position.offset += size;
+	chunk.position.address += size;
 
-		address += 1;
-	}
-	else
+	if (type != BranchType::FIXED && !isNear)
 	{
-		error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
+		chunk.branches.push_back({ chunk.position.instruction, instruction.operands[0].index, chunk.position.address, chunk.position.isAbsolute });
 	}
+	return true;
 }
 
-void CodeGenerator::GPRAndNumberInstruction(const Instruction& instruction)
+static const Opcode* findJump(uint8_t mnemonic, uint8_t size)
 {
-	if (const auto [opcode, _] = getInstructionOpcode(instruction.token.stringValue, instruction.arguments.at(0).token.stringValue, "I", (uint8_t*)&instruction.arguments.at(0).token.size, (uint8_t*)&instruction.arguments.at(1).token.size, true, false); opcode != -1)
-	{
-		output << (uint8_t)opcode;
+	return getInstructionOpcode(mnemonic, OperandClass::J, OperandClass::NONE, &size, nullptr);
+}
 
-		address += 1;
+static const Opcode* const shortJump = findJump(jmpShortMnemonic, 1);
+static const Opcode* const nearJump = findJump(jmpMnemonic, 2);
 
-		streamNumber(instruction.arguments.at(1).token.numberValue, instruction.arguments.at(1).token.size);
+void CodeGenerator::encodeBranch(const Instruction& instruction, const Encoding& encoding, EncodingChunk& chunk)
+{
+	EncodingPosition& position = chunk.position;
+	BranchType type = getBranchType(instruction, *encoding.opcode);
+	uint8_t size = type == BranchType::FIXED ? encoding.sizes[0] : instruction.size == 2 ? 2 : 1;
 
-		address += instruction.arguments.at(1).token.size;
-	}
-	else if (const auto [opcode, extension] = getInstructionOpcode(instruction.token.stringValue, "G", "I", (uint8_t*)&instruction.arguments.at(0).token.size, (uint8_t*)&instruction.arguments.at(1).token.size, true, false); opcode != -1)
+	if (type == BranchType::CONDITIONAL && size == 2)
 	{
-		output << (uint8_t)opcode;
-
-		address += 1;
-
-		AddresingMode addressingMode = { 0b00, instruction.arguments.at(0).token.numberValue, 0 };
-
-		if (extension != -1) 
-		{
-			addressingMode.mod = 0b11;
-			addressingMode.reg = extension;
-			addressingMode.rm = instruction.arguments.at(0).token.numberValue;
-		}
-
-		output << addressingMode.to_uint8t();
-
-		address += 1;
-
-		streamNumber(instruction.arguments.at(1).token.numberValue, instruction.arguments.at(1).token.size);
-
-		address += instruction.arguments.at(1).token.size;
+		output[position.offset++] = encoding.opcode->opcode ^ 1;
+		output[position.offset++] = 3;
+		output[position.offset++] = nearJump->opcode;
+		position.address += 2;
 	}
 	else
 	{
-		error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
+		output[position.offset++] = type == BranchType::JUMP && size == 1 ? shortJump->opcode : encoding.opcode->opcode;
 	}
+	position.address += 1;
+
+	streamLabel(chunk, instruction.operands[0].index, size, true, instruction.line);
 }
 
-void CodeGenerator::GPRAndOffsetInstruction(const Instruction& instruction, const std::string& label)
+Label& CodeGenerator::getLabel(uint32_t symbol)
 {
-	uint8_t offsetSize = 2;
-	if (const auto [opcode, _] = getInstructionOpcode(instruction.token.stringValue, instruction.arguments.at(0).token.stringValue, "I", (uint8_t*)&instruction.arguments.at(0).token.size, &offsetSize, false, false); opcode != -1)
+	if (symbol >= labels.size())
 	{
-		output << (uint8_t)opcode;
-
-		address += 1;
+		labels.resize(symbol + 1);
+	}
+	return labels[symbol];
+}
 
-		address += offsetSize;
+const Label& CodeGenerator::findLabel(uint32_t symbol) const
+{
+	static const Label undefined{};
+	return symbol < labels.size() ? labels[symbol] : undefined;
+}
 
-		if (const auto& it = labels.find(label); it != labels.end())
+// Only references to labels that were not defined yet when their chunk was encoded are left here
+void CodeGenerator::patchLabels()
+{
+	std::vector<std::string_view> notFound;
+	for (const auto& labelToPatch : labelsToPatch)
+	{
+		if (const Label& label = findLabel(labelToPatch.label); label.defined)
 		{
-			streamNumber(it->second.address - address, offsetSize);
+			int64_t value = label.address - labelToPatch.relativeTo;
+			if (labelToPatch.size == 1 && !isSignExtendedByte(value))
+			{
+				error(labelToPatch.line, "Jump target out of range");
+			}
+			patchNumber(labelToPatch.offset, value, labelToPatch.size);
 		}
 		else
 		{
-			streamNumber(0, offsetSize);
-			labelsToPatch.insert({ label, { (uint16_t)(address - offsetSize), 0, offsetSize } });
+			notFound.push_back(symbols.name(labelToPatch.label));
 		}
 	}
-	else
+	std::stable_sort(notFound.begin(), notFound.end());
+	labelsNotFound = !notFound.empty();
+	for (const auto& labelToPatch : notFound) 
 	{
-		error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
+		std::cout << labelToPatch << ": not found" << '\n';
 	}
 }
 
-void CodeGenerator::RegisterAndMemoryAddressingInstruction(const Instruction& instruction, const std::string& operandA, const std::string& operandB)
+void CodeGenerator::orgInstruction(const Instruction& instruction, EncodingPosition& position)
 {
-	MemoryAddresing memoryAddressing = resolveMemoryAddressing(instruction.arguments.at(1).right.get());
+	position.startAddress = instruction.operands[0].number;
+	position.address = position.startAddress;
+	position.isAbsolute = true;
+}
 
-	if (const auto [opcode, _] = getInstructionOpcode(instruction.token.stringValue, "G", "M", (uint8_t*)&instruction.arguments.at(0).token.size, (uint8_t*)&instruction.arguments.at(1).token.size, true, false); opcode != -1)
+void CodeGenerator::defineDataInstruction(const Instruction& instruction, EncodingChunk& chunk)
+{
+	const DataItem* end = arena->dataEnd(instruction.data);
+	for (const DataItem* item = arena->dataBegin(instruction.data); item != end; item++)
 	{
-		output << (uint8_t)opcode;
-
-		address += 1;
-
-		AddresingMode addresingMode = { memoryAddressing.addressingMode.mod, instruction.arguments.at(0).token.numberValue, memoryAddressing.addressingMode.rm };
-
-		output << addresingMode.to_uint8t();
-
-		address += 1;
+		if (item->type == TokenType::NUMBER)
+		{
+			const DataItem* last = std::find_if(item, end, [](const DataItem& next) { return next.type != TokenType::NUMBER; });
+			streamNumbers(chunk, item, last, instruction.size);
+			chunk.position.address += instruction.size * (uint16_t)(last - item);
+			item = last - 1;
+		}
+		else if (item->type == TokenType::STRING)
+		{
+			streamString(chunk, { item->string.data, item->string.size }, instruction.size);
+			chunk.position.address += instruction.size * item->string.size;
+		}
+		else if (item->type == TokenType::DUPDATA_OPERATOR) 
+		{
+			int64_t amount = evaluate(item->dup.amount, item->line, chunk.position);
+			int64_t data = evaluate(item->dup.value, item->line, chunk.position);
+			fillNumber(chunk, data, instruction.size, amount);
+			chunk.position.address += instruction.size * amount;
+		}
+		else 
+		{
+			error(item->line, std::string(dataDefiningInstructions[instruction.mnemonic].name) + ": data expected");
+		}
+	}
+}
 
-		streamNumber(memoryAddressing.displacement, memoryAddressing.displacementSize);
+void CodeGenerator::invalidOperands(const Instruction& instruction) const
+{
+	error(instruction.line, std::string(mnemonics[instruction.mnemonic]) + ": invalid operands");
+}
 
-		address += memoryAddressing.displacementSize;
-	}
-	else
+bool CodeGenerator::measureInvalidOperands(const Instruction& instruction, EncodingChunk& chunk) const
+{
+	if (chunk.position.isPlaced)
 	{
-		error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
+		invalidOperands(instruction);
 	}
+	return false;
 }
 
-void CodeGenerator::MemoryAddressingAndRegisterInstruction(const Instruction& instruction, const std::string& operandA, const std::string& operandB)
+void CodeGenerator::encodeInvalidOperands(const Instruction& instruction, EncodingChunk&)
 {
-	MemoryAddresing memoryAddressing = resolveMemoryAddressing(instruction.arguments.at(0).right.get());
-
-	if (const auto [opcode, _] = getInstructionOpcode(instruction.token.stringValue, operandA, operandB, (uint8_t*)&instruction.arguments.at(0).token.size, (uint8_t*)&instruction.arguments.at(1).token.size, true, false); opcode != -1)
-	{
-		output << (uint8_t)opcode;
+	invalidOperands(instruction);
+}
 
-		address += 1;
+static constexpr bool isRegisterForm(OperandForm form)
+{
+	return form == OperandForm::REGISTER || form == OperandForm::SEGMENT_REGISTER;
+}
 
-		AddresingMode addresingMode = { memoryAddressing.addressingMode.mod, instruction.arguments.at(1).token.numberValue, memoryAddressing.addressingMode.rm };
+static constexpr bool isMemoryForm(OperandForm form, bool isOnlyOperand)
+{
+	return form == OperandForm::MEMORY || (form == OperandForm::LABEL && !isOnlyOperand);
+}
 
-		output << addresingMode.to_uint8t();
+static constexpr OperandClass getFormOperandClass(OperandForm form, bool isOnlyOperand)
+{
+	switch (form)
+	{
+		case OperandForm::REGISTER: return OperandClass::G;
+		case OperandForm::SEGMENT_REGISTER: return OperandClass::S;
+		case OperandForm::NUMBER:
+		case OperandForm::EXPRESSION:
+		case OperandForm::OFFSET: return OperandClass::I;
+		case OperandForm::MEMORY: return OperandClass::M;
+		case OperandForm::LABEL: return isOnlyOperand ? OperandClass::J : OperandClass::M;
+		default: return OperandClass::NONE;
+	}
+}
 
-		address += 1;
+// Size a label reference is looked up with: a jump starts from rel8, a direct address matches any memory size
+static constexpr uint8_t getReferenceSize(OperandForm form, bool isOnlyOperand)
+{
+	return form == OperandForm::OFFSET ? 2 : form == OperandForm::LABEL && isOnlyOperand ? 1 : 0;
+}
 
-		streamNumber(memoryAddressing.displacement, memoryAddressing.displacementSize);
+// The displacement is the first constant left after folding, registers add up to the index
+static const ExpressionCode* findDisplacement(const ExpressionCode* begin, const ExpressionCode* end)
+{
+	return std::find_if(begin, end, [](const ExpressionCode& code) { return code.operation == ExpressionOperation::NUMBER; });
+}
 
-		address += memoryAddressing.displacementSize;
+// A register paired with nothing, a number or an offset first tries the short forms that name it (push ax, mov ax, imm)
+template <OperandForm A, OperandForm B>
+Encoding CodeGenerator::lookUp(const Instruction& instruction)
+{
+	constexpr bool isOnlyOperand = B == OperandForm::NONE;
+	constexpr bool hasMemoryOperand = isMemoryForm(A, isOnlyOperand) || isMemoryForm(B, false);
+	constexpr bool triesRegisterClass = isRegisterForm(A) && (B == OperandForm::NONE || B == OperandForm::NUMBER || B == OperandForm::OFFSET);
+	constexpr bool triesGeneralClass = !isRegisterForm(A) || B == OperandForm::REGISTER || B == OperandForm::SEGMENT_REGISTER || B == OperandForm::NUMBER || hasMemoryOperand;
+
+	const Operand* operands = instruction.operands;
+
+	// Sizes are widened to the matched encoding by the lookup
+	Encoding encoding = { nullptr, false, {
+		A == OperandForm::LABEL || A == OperandForm::OFFSET ? getReferenceSize(A, isOnlyOperand) : operands[0].size,
+		B == OperandForm::LABEL || B == OperandForm::OFFSET ? getReferenceSize(B, false) : operands[1].size,
+	} };
+	uint8_t* sizeA = A == OperandForm::NONE ? nullptr : &encoding.sizes[0];
+	uint8_t* sizeB = B == OperandForm::NONE ? nullptr : &encoding.sizes[1];
+
+	if constexpr (triesRegisterClass)
+	{
+		encoding.opcode = getInstructionOpcode(instruction.mnemonic, getOperandClass(operands[0]), getFormOperandClass(B, false), sizeA, sizeB);
 	}
-	else
+	if constexpr (triesGeneralClass)
 	{
-		error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
+		if (!encoding.opcode)
+		{
+			encoding.opcode = getInstructionOpcode(instruction.mnemonic, getFormOperandClass(A, isOnlyOperand), getFormOperandClass(B, false), sizeA, sizeB);
+			encoding.hasModRM = !isOnlyOperand || hasMemoryOperand;
+		}
 	}
+
+	return encoding;
 }
 
-void CodeGenerator::MemoryAddressingAndNumberInstruction(const Instruction& instruction)
+// Sum of the register indices of a memory operand that holds registers and at most one constant, -1 when it holds more
+static int64_t getRegisterSum(const ExpressionCode* begin, const ExpressionCode* end)
 {
-	MemoryAddresing memoryAddressing = resolveMemoryAddressing(instruction.arguments.at(0).right.get());
+	int64_t sum = 0;
+	size_t numbers = 0;
+	for (const ExpressionCode* code = begin; code != end; code++)
+	{
+		if (code->operation == ExpressionOperation::REGISTER)
+		{
+			sum += code->value;
+		}
+		else if (code->operation == ExpressionOperation::NUMBER)
+		{
+			numbers++;
+		}
+		else if (code->operation != ExpressionOperation::ADD)
+		{
+			return -1;
+		}
+	}
+	return numbers <= 1 ? sum : -1;
+}
 
-	if (const auto [opcode, extension] = getInstructionOpcode(instruction.token.stringValue, "M", "I", (uint8_t*)&instruction.arguments.at(0).token.size, (uint8_t*)&instruction.arguments.at(1).token.size, true, false); opcode != -1)
+// -O picks the shortest encoding doing the same as the one lookUp finds: an accumulator form, a sign-extended imm8,
+// or moffs for a direct address
+template <OperandForm A, OperandForm B>
+Encoding CodeGenerator::lookUpShortest(const Instruction& instruction) const
+{
+	Encoding encoding = lookUp<A, B>(instruction);
+	if (!optimizesSize || !encoding.opcode)
 	{
-		output << (uint8_t)opcode;
+		return encoding;
+	}
 
-		address += 1;
+	const Operand* operands = instruction.operands;
+	uint8_t size = encoding.sizes[0];
 
-		AddresingMode addresingMode = { memoryAddressing.addressingMode.mod, memoryAddressing.addressingMode.rm, 0b000 };
+	if constexpr (B == OperandForm::NUMBER && (A == OperandForm::REGISTER || A == OperandForm::MEMORY || A == OperandForm::LABEL))
+	{
+		// Bytes after the opcode, other than the displacement every form shares
+		uint8_t length = encoding.hasModRM + encoding.sizes[1];
 
-		if (extension != -1)
+		const Opcode* accumulator = A == OperandForm::REGISTER ? getExactInstructionOpcode(instruction.mnemonic, getOperandClass(operands[0]), OperandClass::I, size, size) : nullptr;
+		if (accumulator && size < length)
 		{
-			addresingMode.reg = extension;
-			addresingMode.rm = memoryAddressing.addressingMode.rm;
+			encoding = { accumulator, false, { size, size } };
+			length = size;
 		}
 
-		output << addresingMode.to_uint8t();
+		// 83h is the group that sign-extends its imm8, the shifts list other word forms with a byte operand
+		const Opcode* signExtended = size == 2 && isSignExtendedByte(operands[1].number) ? getExactInstructionOpcode(instruction.mnemonic, getFormOperandClass(A, false), OperandClass::I, 2, 1) : nullptr;
+		if (signExtended && signExtended->opcode == 0x83 && 2 < length)
+		{
+			encoding = { signExtended, true, { 2, 1 } };
+		}
+	}
+	else if constexpr ((A == OperandForm::REGISTER && (B == OperandForm::MEMORY || B == OperandForm::LABEL)) || ((A == OperandForm::MEMORY || A == OperandForm::LABEL) && B == OperandForm::REGISTER))
+	{
+		constexpr bool isRegisterFirst = A == OperandForm::REGISTER;
+		const Operand& memory = operands[isRegisterFirst ? 1 : 0];
+		OperandClass registerClass = getOperandClass(operands[isRegisterFirst ? 0 : 1]);
 
-		address += 1;
+		bool isDirect = true;
+		if (memory.type == TokenType::MEMORY_ADDRESSING)
+		{
+			const ExpressionCode* begin = arena->expressionBegin(memory.index);
+			const ExpressionCode* end = arena->expressionEnd(memory.index);
+			isDirect = getRegisterSum(begin, end) == 0 && findDisplacement(begin, end) != end;
+		}
 
-		streamNumber(memoryAddressing.displacement, memoryAddressing.displacementSize);
+		const Opcode* moffs = isDirect ? getExactInstructionOpcode(instruction.mnemonic, isRegisterFirst ? registerClass : OperandClass::M, isRegisterFirst ? OperandClass::M : registerClass, encoding.sizes[0], encoding.sizes[1]) : nullptr;
+		if (moffs)
+		{
+			encoding = { moffs, false, { encoding.sizes[0], encoding.sizes[1] } };
+		}
+	}
 
-		address += memoryAddressing.displacementSize;
+	return encoding;
+}
 
-		streamNumber(instruction.arguments.at(1).token.numberValue, instruction.arguments.at(1).token.size);
+// The displacement bytes of a memory operand. -O leaves out a zero displacement after registers other than a lone bp,
+// and gives [bp] the disp8 and a direct address the disp16 that mod 00 cannot go without
+uint8_t CodeGenerator::getDisplacementSize(const ExpressionCode* begin, const ExpressionCode* end) const
+{
+	const ExpressionCode* displacement = findDisplacement(begin, end);
+	uint8_t size = displacement != end ? displacement->size : 0;
+	if (!optimizesSize)
+	{
+		return size;
+	}
 
-		address += instruction.arguments.at(1).token.size;
+	int64_t registers = getRegisterSum(begin, end);
+	if (registers == 0 && displacement != end)
+	{
+		return 2;
 	}
-	else
+	if (registers == 5)
 	{
-		error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
+		return std::max<uint8_t>(size, 1);
 	}
+	return registers > 0 && displacement != end && displacement->value == 0 ? 0 : size;
 }
 
-void CodeGenerator::RegisterAndLabelInstruction(const Instruction& instruction, const std::string& operandA, const std::string& operandB, const std::string& label)
+template <OperandForm A, OperandForm B>
+bool CodeGenerator::measure(const Instruction& instruction, EncodingChunk& chunk) const
 {
-	uint8_t offsetSize = 0;
-	if (const auto [opcode, _] = getInstructionOpcode(instruction.token.stringValue, "G", "M", (uint8_t*)&instruction.arguments.at(0).token.size, &offsetSize, true, false); opcode != -1)
-	{
-		output << (uint8_t)opcode;
-
-		address += 1;
-
-		AddresingMode addresingMode = { 0b00, instruction.arguments.at(0).token.numberValue, 0b110 };
-
-		output << addresingMode.to_uint8t();
-		
-		address += 1;
+	constexpr bool isOnlyOperand = B == OperandForm::NONE;
+	constexpr bool hasMemoryOperand = isMemoryForm(A, isOnlyOperand) || isMemoryForm(B, false);
 
-		address += 2;
+	const Operand* operands = instruction.operands;
 
-		if (const auto& it = labels.find(label); it != labels.end())
+	if constexpr (A == OperandForm::EXPRESSION)
+	{
+		if (!tryEvaluate(operands[0].index, instruction.line, chunk))
 		{
-			streamNumber(it->second.address - address, 2);
+			return false;
 		}
-		else
+	}
+
+	uint16_t size = 0;
+	if constexpr (A == OperandForm::MEMORY || B == OperandForm::MEMORY)
+	{
+		uint32_t expression = operands[A == OperandForm::MEMORY ? 0 : 1].index;
+		if (!tryEvaluate(expression, instruction.line, chunk))
 		{
-			streamNumber(0, 2);
-			labelsToPatch.insert({ label, { (uint16_t)(address - 2), 0, 2 } });
+			return false;
 		}
+
+		size += getDisplacementSize(arena->expressionBegin(expression), arena->expressionEnd(expression));
 	}
-	else
+	else if constexpr (hasMemoryOperand)
 	{
-		error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
+		size += 2;
 	}
-}
 
-void CodeGenerator::LabelAndRegisterInstruction(const Instruction& instruction, const std::string& operandA, const std::string& operandB, const std::string& label)
-{
-	uint8_t offsetSize = 0;
-	if (const auto [opcode, _] = getInstructionOpcode(instruction.token.stringValue, "M", "G", &offsetSize, (uint8_t*)&instruction.arguments.at(1).token.size, false, true); opcode != -1)
+	Encoding encoding = lookUpShortest<A, B>(instruction);
+	if (!encoding.opcode)
 	{
-		output << (uint8_t)opcode;
+		return measureInvalidOperands(instruction, chunk);
+	}
+	if constexpr (A == OperandForm::LABEL && isOnlyOperand)
+	{
+		return measureBranch(instruction, encoding, chunk);
+	}
 
-		address += 1;
+	size += 1 + encoding.hasModRM;
 
-		AddresingMode addresingMode = { 0b00, instruction.arguments.at(1).token.numberValue, 0b110 };
+	if constexpr (B == OperandForm::OFFSET)
+	{
+		size += encoding.sizes[1];
+	}
+	else if constexpr (B == OperandForm::NUMBER || (isOnlyOperand && (A == OperandForm::NUMBER || A == OperandForm::EXPRESSION)))
+	{
+		size += encoding.sizes[isOnlyOperand ? 0 : 1];
+	}
 
-		output << addresingMode.to_uint8t();
+	chunk.position.offset += size;
+	chunk.position.address += size;
+	return true;
+}
 
-		address += 1;
+template <OperandForm A, OperandForm B>
+void CodeGenerator::encode(const Instruction& instruction, EncodingChunk& chunk)
+{
+	constexpr bool isOnlyOperand = B == OperandForm::NONE;
+	constexpr bool hasMemoryOperand = isMemoryForm(A, isOnlyOperand) || isMemoryForm(B, false);
 
-		address += 2;
+	const Operand* operands = instruction.operands;
+	EncodingPosition& position = chunk.position;
 
-		if (const auto& it = labels.find(label); it != labels.end())
-		{
-			streamNumber(it->second.address - address, 2);
-		}
-		else
-		{
-			streamNumber(0, 2);
-			labelsToPatch.insert({ label, { (uint16_t)(address - 2), 0, 2 } });
-		}
+	int64_t immediate = 0;
+	if constexpr (A == OperandForm::EXPRESSION)
+	{
+		immediate = evaluate(operands[0].index, instruction.line, position);
 	}
-	else
+	else if constexpr (B == OperandForm::NUMBER || A == OperandForm::NUMBER)
 	{
-		error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
+		immediate = operands[B == OperandForm::NUMBER ? 1 : 0].number;
 	}
-}
 
-void CodeGenerator::LabelAndNumberInstruction(const Instruction& instruction, const std::string& label)
-{
-	uint8_t offsetSize = 0;
-	if (const auto [opcode, extension] = getInstructionOpcode(instruction.token.stringValue, "M", "I", &offsetSize, (uint8_t*)&instruction.arguments.at(1).token.size, false, false); opcode != -1)
+	MemoryAddresing memoryAddressing = { { 0b00, 0b000, 0b110 }, 0, 0 };
+	if constexpr (A == OperandForm::MEMORY || B == OperandForm::MEMORY)
 	{
-		output << (uint8_t)opcode;
-
-		address += 1;
-
-		AddresingMode addresingMode = { 0b00, 0b110, 0b000 };
+		memoryAddressing = resolveMemoryAddressing(operands[A == OperandForm::MEMORY ? 0 : 1].index, instruction.line, position);
+	}
 
-		if (extension != -1)
-		{
-			addresingMode.reg = extension;
-			addresingMode.rm = 0b110;
-		}
+	Encoding encoding = lookUpShortest<A, B>(instruction);
+	if (!encoding.opcode)
+	{
+		invalidOperands(instruction);
+	}
+	if constexpr (A == OperandForm::LABEL && isOnlyOperand)
+	{
+		encodeBranch(instruction, encoding, chunk);
+		return;
+	}
+	const Opcode* opcode = encoding.opcode;
 
-		output << addresingMode.to_uint8t();
+	output[position.offset++] = opcode->opcode;
 
-		address += 1;
+	position.address += 1;
 
-		address += 2;
+	if (encoding.hasModRM)
+	{
+		AddresingMode addressingMode;
 
-		if (const auto& it = labels.find(label); it != labels.end())
+		if constexpr (hasMemoryOperand)
+		{
+			addressingMode = memoryAddressing.addressingMode;
+			addressingMode.reg = isRegisterForm(A) ? operands[0].index : isRegisterForm(B) ? operands[1].index : opcode->opcodeExtension;
+		}
+		else if constexpr (isRegisterForm(B))
 		{
-			streamNumber(it->second.address - address, 2);
+			addressingMode = { 0b11, (uint8_t)operands[0].index, (uint8_t)operands[1].index };
 		}
 		else
 		{
-			streamNumber(0, 2);
-			labelsToPatch.insert({ label, { (uint16_t)(address - 2), 0, 2 } });
+			addressingMode = { 0b11, opcode->opcodeExtension, (uint8_t)operands[0].index };
 		}
 
-		streamNumber(instruction.arguments.at(1).token.numberValue, instruction.arguments.at(1).token.size);
+		output[position.offset++] = addressingMode.to_uint8t();
 
-		address += instruction.arguments.at(1).token.size;
+		position.address += 1;
 	}
-	else
+
+	if constexpr (A == OperandForm::MEMORY || B == OperandForm::MEMORY)
 	{
-		error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
+		streamNumber(chunk, memoryAddressing.displacement, memoryAddressing.displacementSize);
+
+		position.address += memoryAddressing.displacementSize;
+	}
+	else if constexpr (hasMemoryOperand)
+	{
+		streamLabel(chunk, operands[A == OperandForm::LABEL ? 0 : 1].index, 2, false);
 	}
-}
 
-void CodeGenerator::LabelAndOffsetInstruction(const Instruction& instruction, const std::string& label, const std::string& secondLabel)
-{
-	uint8_t offsetSize = 0;
-	uint8_t secondOffsetSize = 2;
-	if (const auto [opcode, extension] = getInstructionOpcode(instruction.token.stringValue, "M", "I", &offsetSize, &secondOffsetSize, false, false); opcode != -1)
+	if constexpr (B == OperandForm::OFFSET)
+	{
+		streamLabel(chunk, operands[1].index, encoding.sizes[1], false);
+	}
+	else if constexpr (B == OperandForm::NUMBER || (isOnlyOperand && (A == OperandForm::NUMBER || A == OperandForm::EXPRESSION)))
 	{
-		output << (uint8_t)opcode;
+		uint8_t immediateSize = encoding.sizes[isOnlyOperand ? 0 : 1];
+
+		streamNumber(chunk, immediate, immediateSize);
 
-		address += 1;
+		position.address += immediateSize;
+	}
+}
 
-		AddresingMode addresingMode = { 0b00, 0b110, 0b000 };
+template <OperandForm A, OperandForm B>
+constexpr CodeGenerator::Encoder CodeGenerator::makeEncoder()
+{
+	return { &CodeGenerator::measure<A, B>, &CodeGenerator::encode<A, B> };
+}
 
-		if (extension != -1)
+// Segment registers next to memory or a label go through the general register encoders, as they always have
+constexpr CodeGenerator::EncoderTable CodeGenerator::makeEncoders()
+{
+	EncoderTable table{};
+	for (auto& row : table)
+	{
+		for (auto& encoder : row)
 		{
-			addresingMode.reg = extension;
-			addresingMode.rm = 0b110;
-			offsetSize = 2;
+			encoder = { &CodeGenerator::measureInvalidOperands, &CodeGenerator::encodeInvalidOperands };
 		}
+	}
 
-		output << addresingMode.to_uint8t();
-
-		address += 1;
+	auto set = [&table](OperandForm a, OperandForm b, Encoder encoder)
+	{
+		table[(size_t)a][(size_t)b] = encoder;
+	};
+
+	set(OperandForm::NONE, OperandForm::NONE, makeEncoder<OperandForm::NONE, OperandForm::NONE>());
+
+	set(OperandForm::REGISTER, OperandForm::NONE, makeEncoder<OperandForm::REGISTER, OperandForm::NONE>());
+	set(OperandForm::SEGMENT_REGISTER, OperandForm::NONE, makeEncoder<OperandForm::SEGMENT_REGISTER, OperandForm::NONE>());
+	set(OperandForm::NUMBER, OperandForm::NONE, makeEncoder<OperandForm::NUMBER, OperandForm::NONE>());
+	set(OperandForm::EXPRESSION, OperandForm::NONE, makeEncoder<OperandForm::EXPRESSION, OperandForm::NONE>());
+	set(OperandForm::MEMORY, OperandForm::NONE, makeEncoder<OperandForm::MEMORY, OperandForm::NONE>());
+	set(OperandForm::LABEL, OperandForm::NONE, makeEncoder<OperandForm::LABEL, OperandForm::NONE>());
+
+	set(OperandForm::REGISTER, OperandForm::REGISTER, makeEncoder<OperandForm::REGISTER, OperandForm::REGISTER>());
+	set(OperandForm::REGISTER, OperandForm::SEGMENT_REGISTER, makeEncoder<OperandForm::REGISTER, OperandForm::SEGMENT_REGISTER>());
+	set(OperandForm::SEGMENT_REGISTER, OperandForm::REGISTER, makeEncoder<OperandForm::SEGMENT_REGISTER, OperandForm::REGISTER>());
+	set(OperandForm::REGISTER, OperandForm::NUMBER, makeEncoder<OperandForm::REGISTER, OperandForm::NUMBER>());
+	set(OperandForm::REGISTER, OperandForm::OFFSET, makeEncoder<OperandForm::REGISTER, OperandForm::OFFSET>());
+
+	set(OperandForm::REGISTER, OperandForm::MEMORY, makeEncoder<OperandForm::REGISTER, OperandForm::MEMORY>());
+	set(OperandForm::SEGMENT_REGISTER, OperandForm::MEMORY, makeEncoder<OperandForm::REGISTER, OperandForm::MEMORY>());
+	set(OperandForm::MEMORY, OperandForm::REGISTER, makeEncoder<OperandForm::MEMORY, OperandForm::REGISTER>());
+	set(OperandForm::MEMORY, OperandForm::SEGMENT_REGISTER, makeEncoder<OperandForm::MEMORY, OperandForm::REGISTER>());
+	set(OperandForm::MEMORY, OperandForm::NUMBER, makeEncoder<OperandForm::MEMORY, OperandForm::NUMBER>());
+
+	set(OperandForm::REGISTER, OperandForm::LABEL, makeEncoder<OperandForm::REGISTER, OperandForm::LABEL>());
+	set(OperandForm::SEGMENT_REGISTER, OperandForm::LABEL, makeEncoder<OperandForm::REGISTER, OperandForm::LABEL>());
+	set(OperandForm::LABEL, OperandForm::REGISTER, makeEncoder<OperandForm::LABEL, OperandForm::REGISTER>());
+	set(OperandForm::LABEL, OperandForm::SEGMENT_REGISTER, makeEncoder<OperandForm::LABEL, OperandForm::REGISTER>());
+	set(OperandForm::LABEL, OperandForm::NUMBER, makeEncoder<OperandForm::LABEL, OperandForm::NUMBER>());
+	set(OperandForm::LABEL, OperandForm::OFFSET, makeEncoder<OperandForm::LABEL, OperandForm::OFFSET>());
+
+	return table;
+}
 
-		address += 2;
+const CodeGenerator::EncoderTable CodeGenerator::encoders = CodeGenerator::makeEncoders();
 
-		if (const auto& it = labels.find(label); it != labels.end())
-		{
-			streamNumber(it->second.address - address, 2);
-		}
-		else
-		{
-			streamNumber(0, 2);
-			labelsToPatch.insert({ label, { (uint16_t)(address - 2), 0, 2 } });
-		}
+OperandForm CodeGenerator::getOperandForm(const Operand& operand)
+{
+	switch (operand.type)
+	{
+		case TokenType::REGISTER: return OperandForm::REGISTER;
+		case TokenType::SEGMENT_REGISTER: return OperandForm::SEGMENT_REGISTER;
+		case TokenType::NUMBER: return OperandForm::NUMBER;
+		case TokenType::ARITHMETIC_BINARY_OPERATOR:
+		case TokenType::ARITHMETIC_UNARY_OPERATOR:
+		case TokenType::GETSTARTADDRESS_OPERATOR:
+		case TokenType::GETCURRENTADDRESS_OPERATOR:
+		case TokenType::GETPROGRAMSIZE_OPERATOR: return OperandForm::EXPRESSION;
+		case TokenType::MEMORY_ADDRESSING: return OperandForm::MEMORY;
+		case TokenType::LOCAL_LABEL:
+		case TokenType::GLOBAL_LABEL: return OperandForm::LABEL;
+		case TokenType::GETOFFSET_OPERATOR: return OperandForm::OFFSET;
+		default: return OperandForm::OTHER;
+	}
+}
 
-		address += secondOffsetSize;
+// A reference to a label defined before it is always relative. One defined later is relative only when isRelative is set,
+// one not defined yet is left for patchLabels
+void CodeGenerator::streamLabel(EncodingChunk& chunk, uint32_t label, uint8_t size, bool isRelative, uint32_t line)
+{
+	EncodingPosition& position = chunk.position;
+	position.address += size;
 
-		if (const auto& it = labels.find(secondLabel); it != labels.end())
-		{
-			streamNumber(it->second.address - address, secondOffsetSize);
-		}
-		else
-		{
-			streamNumber(0, offsetSize);
-			labelsToPatch.insert({ label, { (uint16_t)(address - secondOffsetSize), 0, secondOffsetSize } });
-		}
+	if (const Label& found = findLabel(label); found.defined && found.instruction < position.instruction)
+	{
+		streamNumber(chunk, found.address - position.address, size);
+	}
+	else if (found.defined)
+	{
+		streamNumber(chunk, found.address - (isRelative ? position.address : 0), size);
 	}
 	else
 	{
-		error(instruction.token.line, instruction.token.stringValue + ": invalid operands");
+		streamNumber(chunk, 0, size);
+		chunk.labelsToPatch.push_back({ (uint32_t)(position.offset - size), (uint16_t)(isRelative ? position.address : 0), size, label, line });
 	}
 }
 
-MemoryAddresing CodeGenerator::resolveMemoryAddressing(Node* node)
+MemoryAddresing CodeGenerator::resolveMemoryAddressing(uint32_t expression, uint32_t line, const EncodingPosition& position) const
 {
 	AddresingMode addressingMode;
 
-	Node* displacementNode = findNumber(node);
-	int16_t displacement = 0;
-	uint8_t displacementSize = 0;
+	const ExpressionCode* begin = arena->expressionBegin(expression);
+	const ExpressionCode* end = arena->expressionEnd(expression);
 
-	resolveGetaddressOperators(node);
-	Node valuesSumNode = Parser::performArithmeticOperations(*node, true);
+	int16_t displacement = 0;
+	uint8_t displacementSize = getDisplacementSize(begin, end);
 
-	if (displacementNode) 
+	const ExpressionCode* displacementCode = findDisplacement(begin, end);
+	if (displacementCode != end) 
 	{
-		displacement = displacementNode->token.numberValue;
-		displacementSize = displacementNode->token.size;
+		displacement = displacementCode->value;
 	}
 
+	int64_t valuesSum = evaluateExpression(begin, end, { position.instructionAddress, position.startAddress }, line);
+
 	addressingMode.mod = displacementSize;
 
-	switch (valuesSumNode.token.numberValue - displacement)
+	switch (valuesSum - displacement)
 	{
 		case 9: // 1001 = BX + SI
 		{
@@ -850,14 +1010,112 @@ MemoryAddresing CodeGenerator::resolveMemoryAddressing(Node* node)
 	return { addressingMode, displacement, displacementSize };
 }
 
-void CodeGenerator::streamNumber(int64_t number, uint16_t size){
+int64_t CodeGenerator::evaluate(uint32_t expression, uint32_t line, const EncodingPosition& position) const
+{
+	return evaluateExpression(arena->expressionBegin(expression), arena->expressionEnd(expression), { position.instructionAddress, position.startAddress }, line);
+}
+
+OperandClass CodeGenerator::getOperandClass(const Operand& operand)
+{
+	if (operand.type == TokenType::SEGMENT_REGISTER)
+	{
+		return getSegmentRegisterOperandClass((uint8_t)operand.index);
+	}
+	return getRegisterOperandClass(operand.size, (uint8_t)operand.index);
+}
+
+void CodeGenerator::streamNumber(EncodingChunk& chunk, int64_t number, uint16_t size){
 	for (int i = 0; i < size; i++) 
 	{
-		output << (uint8_t)((number >> (8 * i)) & 0xFF);
+		output[chunk.position.offset++] = (uint8_t)((number >> (8 * i)) & 0xFF);
+	}
+}
+
+template <uint16_t size>
+static void packNumbers(uint8_t* destination, const DataItem* begin, const DataItem* end)
+{
+	for (const DataItem* item = begin; item != end; item++, destination += size)
+	{
+		for (uint16_t i = 0; i < size; i++)
+		{
+			destination[i] = (uint8_t)((item->number >> (8 * i)) & 0xFF);
+		}
+	}
+}
+
+// A run of numbers of a data definition. With the item size fixed per loop the byte stores of an item merge into one
+void CodeGenerator::streamNumbers(EncodingChunk& chunk, const DataItem* begin, const DataItem* end, uint16_t size)
+{
+	uint8_t* destination = output.data() + chunk.position.offset;
+	switch (size)
+	{
+		case 1: packNumbers<1>(destination, begin, end); break;
+		case 2: packNumbers<2>(destination, begin, end); break;
+		case 4: packNumbers<4>(destination, begin, end); break;
+		case 8: packNumbers<8>(destination, begin, end); break;
+	}
+	chunk.position.offset += (size_t)size * (end - begin);
+}
+
+// Repeats number amount times by copying the part already written over the rest, doubling it each time. The output
+// is zeroed when it is resized and every byte is written once, so a zero fill only moves the offset
+void CodeGenerator::fillNumber(EncodingChunk& chunk, int64_t number, uint16_t size, int64_t amount)
+{
+	if (amount <= 0)
+	{
+		return;
+	}
+
+	uint8_t pattern[8] = {};
+	for (int i = 0; i < size; i++)
+	{
+		pattern[i] = (uint8_t)((number >> (8 * i)) & 0xFF);
+	}
+
+	uint8_t* destination = output.data() + chunk.position.offset;
+	size_t total = (size_t)size * amount;
+	chunk.position.offset += total;
+
+	if (std::all_of(pattern, pattern + size, [](uint8_t byte) { return byte == 0; }))
+	{
+		return;
+	}
+	if (size == 1)
+	{
+		std::memset(destination, pattern[0], total);
+		return;
+	}
+
+	std::memcpy(destination, pattern, size);
+	for (size_t filled = size; filled < total; filled *= 2)
+	{
+		std::memcpy(destination + filled, destination, std::min(filled, total - filled));
+	}
+}
+
+void CodeGenerator::patchNumber(size_t offset, int64_t number, uint16_t size)
+{
+	for (int i = 0; i < size; i++)
+	{
+		output[offset + i] = (uint8_t)((number >> (8 * i)) & 0xFF);
+	}
+}
+
+void CodeGenerator::streamString(EncodingChunk& chunk, std::string_view string, uint16_t size)
+{
+	if (size == 1)
+	{
+		std::copy(string.begin(), string.end(), output.begin() + chunk.position.offset);
+		chunk.position.offset += string.size();
+		return;
+	}
+	for (char c : string)
+	{
+		streamNumber(chunk, c, size);
 	}
 }
 
-void CodeGenerator::error(uint16_t line, const std::string& message)
+void CodeGenerator::error(uint32_t line, const std::string& message)
 {
 	std::cout << "Line " << line << ": " << message << '\n';
 	exit(-1);
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <array>
 #include <vector>
-#include <map>
-#include <sstream>
 #include "Instruction.h"
+#include "SpscQueue.h"
+#include "SymbolTable.h"
+#include "instructionsSet.h"
 
 enum class LabelType 
 {
@@ -15,13 +17,70 @@ struct Label
 {
 	LabelType type;
 	uint16_t address;
+	bool defined = false;
+	uint32_t instruction = 0;
 };
 
 struct LabelToPatch 
 {
-	uint16_t outputAddress;
+	uint32_t offset;
 	uint16_t relativeTo;
 	uint8_t size;
+	uint32_t label = 0;
+	uint32_t line = 0;
+};
+
+struct LabelDeclaration
+{
+	uint32_t symbol;
+	uint32_t instruction;
+	uint16_t address;
+	bool isAbsolute;
+};
+
+// A short jump to a label, with the address it is relative to
+struct BranchReference
+{
+	uint32_t instruction;
+	uint32_t label;
+	uint16_t address;
+	bool isAbsolute;
+};
+
+// Where measuring or encoding stands. Until a chunk is placed its offsets and, before an org, its addresses
+// count from the chunk start, and its errors are left for the serial pass to report
+struct EncodingPosition
+{
+	size_t offset = 0;
+	uint32_t instruction = 0;
+	uint16_t address = 0;
+	uint16_t instructionAddress = 0;
+	uint16_t startAddress = 0;
+	bool isPlaced = true;
+	bool isAbsolute = true;
+};
+
+// A run of instructions that is measured and encoded independently of the others
+struct EncodingChunk
+{
+	size_t first = 0;
+	size_t last = 0;
+	EncodingPosition start;
+	EncodingPosition position;
+	bool isMeasured = false;
+	size_t initializedEnd = 0;
+
+	std::vector<LabelDeclaration> labels;
+	std::vector<BranchReference> branches;
+	std::vector<LabelToPatch> labelsToPatch;
+};
+
+// The opcode and operand sizes an instruction is encoded with
+struct Encoding
+{
+	const Opcode* opcode;
+	bool hasModRM;
+	uint8_t sizes[2];
 };
 
 struct AddresingMode 
@@ -36,6 +95,30 @@ struct AddresingMode
 	}
 };
 
+// How a jump to a label is encoded. A conditional jump that does not reach with its rel8 jumps over a near jmp
+// on the inverted condition instead
+enum class BranchType : uint8_t
+{
+	FIXED,
+	SHORT,
+	JUMP,
+	CONDITIONAL,
+};
+
+enum class OperandForm : uint8_t
+{
+	NONE,
+	REGISTER,
+	SEGMENT_REGISTER,
+	NUMBER,
+	EXPRESSION,
+	MEMORY,
+	LABEL,
+	OFFSET,
+	OTHER,
+	COUNT,
+};
+
 struct MemoryAddresing 
 {
 	AddresingMode addressingMode;
@@ -46,52 +129,93 @@ struct MemoryAddresing
 class CodeGenerator 
 {
 	public:
-		CodeGenerator(std::vector<Instruction>& instructions);
-		std::stringstream& generate();
+		CodeGenerator(InstructionSpan instructions, const ParseArena& arena, const SymbolTable& symbols, unsigned threadCount = 1, bool optimizesSize = false);
+		explicit CodeGenerator(const SymbolTable& symbols, bool optimizesSize = false);
+		std::vector<uint8_t>& generate();
+		std::vector<uint8_t>& generate(SpscQueue<ParseBatch>& queue);
+		// Missing labels are reported without failing, their references are left zero
+		bool hasLabelsNotFound() const;
 	private:
-		std::vector<Instruction>& instructions;
-
-		std::stringstream output;
-
-		uint16_t startAddress = 0;
-		uint16_t address = 0;
-		uint16_t instructionAddress = 0;
-
-		std::map<std::string, Label> labels = { {"", {} } };
-
-		std::multimap<std::string, LabelToPatch> labelsToPatch = {};
-
-		std::string currentLabel = "";
-
-		void encodeInstructions();
-
-		void encodeInstruction(const Instruction& instruction);
-
-		void resolveGetaddressOperators(Node *node);
-		void patchLabel(const std::string& label);
-		Node* findNumber(Node* node);
-
-		void orgInstruction(const Instruction& instruction);
-		void defineDataInstruction(const Instruction& instruction);
-		void noOperandsInstruction(const Instruction& instruction);
-		void registerInstruction(const Instruction& instruction);
-		void numberInstruction(const Instruction& instruction);
-		void labelInstruction(const Instruction& instruction, const std::string& label);
-
-		void RegisterAndRegisterInstruction(const Instruction& instruction, const std::string& operandA, const std::string& operandB);
-		void GPRAndNumberInstruction(const Instruction& instruction);
-		void GPRAndOffsetInstruction(const Instruction& instruction, const std::string& label);
-		void RegisterAndMemoryAddressingInstruction(const Instruction& instruction, const std::string& operandA, const std::string& operandB);
-		void MemoryAddressingAndRegisterInstruction(const Instruction& instruction, const std::string& operandA, const std::string& operandB);
-		void MemoryAddressingAndNumberInstruction(const Instruction& instruction);
-
-		void RegisterAndLabelInstruction(const Instruction& instruction, const std::string& operandA, const std::string& operandB, const std::string& label);
-		void LabelAndRegisterInstruction(const Instruction& instruction, const std::string& operandA, const std::string& operandB, const std::string& label);
-		void LabelAndNumberInstruction(const Instruction& instruction, const std::string& label);
-		void LabelAndOffsetInstruction(const Instruction& instruction, const std::string& label, const std::string& secondLabel);
-
-		MemoryAddresing resolveMemoryAddressing(Node *node);
-
-		void streamNumber(int64_t number, uint16_t size);
-		static void error(uint16_t line, const std::string& message);
-};
\ No newline at end of file
+		static constexpr size_t minimumChunkSize = 1 << 14;
+
+		InstructionSpan instructions;
+		const ParseArena* arena = nullptr;
+		const SymbolTable& symbols;
+		unsigned threadCount = 1;
+		bool optimizesSize = false;
+
+		std::vector<uint8_t> output;
+		// Reserved space past the last initialized byte is left out of the output
+		size_t initializedEnd = 0;
+
+		EncodingPosition position;
+
+		// Indexed by symbol id, grows as ids show up when the symbol count is not known up front
+		std::vector<Label> labels;
+
+		std::vector<LabelToPatch> labelsToPatch;
+		bool labelsNotFound = false;
+
+		void encodeInstructions(InstructionSpan instructions, bool isComplete);
+		void measureChunks(InstructionSpan instructions, std::vector<EncodingChunk>& chunks);
+		bool relaxBranches(InstructionSpan instructions, uint32_t firstInstruction, const std::vector<EncodingChunk>& chunks, bool isComplete) const;
+		void placeChunk(EncodingChunk& chunk, const EncodingPosition& placed);
+		bool measureChunk(InstructionSpan instructions, EncodingChunk& chunk) const;
+		void encodeChunk(InstructionSpan instructions, EncodingChunk& chunk);
+
+		bool measureInstruction(const Instruction& instruction, EncodingChunk& chunk) const;
+		bool measureData(const Instruction& instruction, EncodingChunk& chunk) const;
+		bool tryEvaluate(uint32_t expression, uint32_t line, const EncodingChunk& chunk, int64_t* value = nullptr) const;
+
+		void encodeInstruction(const Instruction& instruction, EncodingChunk& chunk);
+
+		static BranchType getBranchType(const Instruction& instruction, const Opcode& opcode);
+		bool measureBranch(const Instruction& instruction, const Encoding& encoding, EncodingChunk& chunk) const;
+		void encodeBranch(const Instruction& instruction, const Encoding& encoding, EncodingChunk& chunk);
+
+		Label& getLabel(uint32_t symbol);
+		const Label& findLabel(uint32_t symbol) const;
+		void patchLabels();
+
+		static void orgInstruction(const Instruction& instruction, EncodingPosition& position);
+		void defineDataInstruction(const Instruction& instruction, EncodingChunk& chunk);
+		void invalidOperands(const Instruction& instruction) const;
+		bool measureInvalidOperands(const Instruction& instruction, EncodingChunk& chunk) const;
+		void encodeInvalidOperands(const Instruction& instruction, EncodingChunk& chunk);
+
+		template <OperandForm A, OperandForm B>
+		static Encoding lookUp(const Instruction& instruction);
+		template <OperandForm A, OperandForm B>
+		Encoding lookUpShortest(const Instruction& instruction) const;
+		uint8_t getDisplacementSize(const ExpressionCode* begin, const ExpressionCode* end) const;
+		template <OperandForm A, OperandForm B>
+		bool measure(const Instruction& instruction, EncodingChunk& chunk) const;
+		template <OperandForm A, OperandForm B>
+		void encode(const Instruction& instruction, EncodingChunk& chunk);
+
+		struct Encoder
+		{
+			bool (CodeGenerator::*measure)(const Instruction& instruction, EncodingChunk& chunk) const;
+			void (CodeGenerator::*encode)(const Instruction& instruction, EncodingChunk& chunk);
+		};
+		using EncoderTable = std::array<std::array<Encoder, (size_t)OperandForm::COUNT>, (size_t)OperandForm::COUNT>;
+
+		// Indexed by the operand forms of the first and second argument
+		static const EncoderTable encoders;
+		static constexpr EncoderTable makeEncoders();
+		template <OperandForm A, OperandForm B>
+		static constexpr Encoder makeEncoder();
+		static OperandForm getOperandForm(const Operand& operand);
+
+		MemoryAddresing resolveMemoryAddressing(uint32_t expression, uint32_t line, const EncodingPosition& position) const;
+		int64_t evaluate(uint32_t expression, uint32_t line, const EncodingPosition& position) const;
+		static OperandClass getOperandClass(const Operand& operand);
+
+		void streamNumber(EncodingChunk& chunk, int64_t number, uint16_t size);
+		void streamNumbers(EncodingChunk& chunk, const DataItem* begin, const DataItem* end, uint16_t size);
+		void fillNumber(EncodingChunk& chunk, int64_t number, uint16_t size, int64_t amount);
+		void streamLabel(EncodingChunk& chunk, uint32_t label, uint8_t size, bool isRelative, uint32_t line = 0);
+		void patchNumber(size_t offset, int64_t number, uint16_t size);
+		void streamString(EncodingChunk& chunk, std::string_view string, uint16_t size);
+		static void error(uint32_t line, const std::string& message);
+};
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+#include "Expression.h"
+
+static bool add(int64_t a, int64_t b, int64_t& result)
+{
+	if (b > 0 ? a > INT64_MAX - b : a < INT64_MIN - b)
+	{
+		return false;
+	}
+	result = a + b;
+	return true;
+}
+
+static bool subtract(int64_t a, int64_t b, int64_t& result)
+{
+	if (b > 0 ? a < INT64_MIN + b : a > INT64_MAX + b)
+	{
+		return false;
+	}
+	result = a - b;
+	return true;
+}
+
+static bool multiply(int64_t a, int64_t b, int64_t& result)
+{
+	if (a > 0 ? (b > INT64_MAX / a || b < INT64_MIN / a) : a < -1 ? (b < INT64_MAX / a || b > INT64_MIN / a) : (a == -1 && b == INT64_MIN))
+	{
+		return false;
+	}
+	result = a * b;
+	return true;
+}
+
+// Square-and-multiply, a negative exponent yields the integer reciprocal of the power
+static ExpressionError power(int64_t base, int64_t exponent, int64_t& result)
+{
+	uint64_t bits = exponent < 0 ? 0 - (uint64_t)exponent : (uint64_t)exponent;
+	int64_t value = 1;
+
+	while (bits != 0)
+	{
+		if ((bits & 1) && !multiply(value, base, value))
+		{
+			return ExpressionError::ARITHMETIC_OVERFLOW;
+		}
+		bits >>= 1;
+		if (bits != 0 && !multiply(base, base, base))
+		{
+			return ExpressionError::ARITHMETIC_OVERFLOW;
+		}
+	}
+
+	if (exponent < 0)
+	{
+		if (value == 0)
+		{
+			return ExpressionError::DIVISION_BY_ZERO;
+		}
+		value = 1 / value;
+	}
+
+	result = value;
+	return ExpressionError::NONE;
+}
+
+bool isOperand(ExpressionOperation operation)
+{
+	return operation <= ExpressionOperation::PROGRAM_SIZE;
+}
+
+bool isUnaryOperation(ExpressionOperation operation)
+{
+	return operation == ExpressionOperation::PLUS || operation == ExpressionOperation::NEGATE;
+}
+
+ExpressionError applyOperation(ExpressionOperation operation, int64_t left, int64_t right, int64_t& result)
+{
+	switch (operation)
+	{
+		case ExpressionOperation::PLUS:
+		{
+			result = right;
+			break;
+		}
+		case ExpressionOperation::NEGATE:
+		{
+			if (!subtract(0, right, result))
+			{
+				return ExpressionError::ARITHMETIC_OVERFLOW;
+			}
+			break;
+		}
+		case ExpressionOperation::ADD:
+		{
+			if (!add(left, right, result))
+			{
+				return ExpressionError::ARITHMETIC_OVERFLOW;
+			}
+			break;
+		}
+		case ExpressionOperation::SUBTRACT:
+		{
+			if (!subtract(left, right, result))
+			{
+				return ExpressionError::ARITHMETIC_OVERFLOW;
+			}
+			break;
+		}
+		case ExpressionOperation::MULTIPLY:
+		{
+			if (!multiply(left, right, result))
+			{
+				return ExpressionError::ARITHMETIC_OVERFLOW;
+			}
+			break;
+		}
+		case ExpressionOperation::DIVIDE:
+		{
+			if (right == 0)
+			{
+				return ExpressionError::DIVISION_BY_ZERO;
+			}
+			if (left == INT64_MIN && right == -1)
+			{
+				return ExpressionError::ARITHMETIC_OVERFLOW;
+			}
+			result = left / right;
+			break;
+		}
+		case ExpressionOperation::POWER:
+		{
+			return power(left, right, result);
+		}
+		default:
+		{
+			break;
+		}
+	}
+	return ExpressionError::NONE;
+}
+
+int64_t evaluateExpression(const ExpressionCode* begin, const ExpressionCode* end, const ExpressionAddresses& addresses, uint32_t line)
+{
+	int64_t result = 0;
+	if (ExpressionError error = tryEvaluateExpression(begin, end, addresses, result); error != ExpressionError::NONE)
+	{
+		std::cout << "Line " << line << ": " << expressionErrorMessage(error) << '\n';
+		exit(-1);
+	}
+	return result;
+}
+
+ExpressionError tryEvaluateExpression(const ExpressionCode* begin, const ExpressionCode* end, const ExpressionAddresses& addresses, int64_t& result)
+{
+	constexpr size_t localStackSize = 32;
+
+	int64_t localStack[localStackSize];
+	std::vector<int64_t> heapStack;
+	int64_t* stack = localStack;
+
+	if ((size_t)(end - begin) > localStackSize)
+	{
+		heapStack.resize(end - begin);
+		stack = heapStack.data();
+	}
+
+	size_t top = 0;
+
+	for (const ExpressionCode* code = begin; code != end; code++)
+	{
+		switch (code->operation)
+		{
+			case ExpressionOperation::NUMBER:
+			case ExpressionOperation::REGISTER:
+			{
+				stack[top++] = code->value;
+				break;
+			}
+			case ExpressionOperation::CURRENT_ADDRESS:
+			{
+				stack[top++] = addresses.current;
+				break;
+			}
+			case ExpressionOperation::START_ADDRESS:
+			{
+				stack[top++] = addresses.start;
+				break;
+			}
+			case ExpressionOperation::PROGRAM_SIZE:
+			{
+				stack[top++] = addresses.current - addresses.start;
+				break;
+			}
+			case ExpressionOperation::PLUS:
+			case ExpressionOperation::NEGATE:
+			{
+				if (ExpressionError error = applyOperation(code->operation, 0, stack[top - 1], stack[top - 1]); error != ExpressionError::NONE)
+				{
+					return error;
+				}
+				break;
+			}
+			default:
+			{
+				top--;
+				if (ExpressionError error = applyOperation(code->operation, stack[top - 1], stack[top], stack[top - 1]); error != ExpressionError::NONE)
+				{
+					return error;
+				}
+				break;
+			}
+		}
+	}
+
+	result = top > 0 ? stack[top - 1] : 0;
+	return ExpressionError::NONE;
+}
+
+bool usesAddress(const ExpressionCode* begin, const ExpressionCode* end)
+{
+	return std::any_of(begin, end, [](const ExpressionCode& code)
+	{
+		return code.operation == ExpressionOperation::CURRENT_ADDRESS || code.operation == ExpressionOperation::START_ADDRESS || code.operation == ExpressionOperation::PROGRAM_SIZE;
+	});
+}
+
+// Every operation but unary plus can overflow, division also by zero
+bool mayFail(const ExpressionCode* begin, const ExpressionCode* end)
+{
+	return std::any_of(begin, end, [](const ExpressionCode& code)
+	{
+		return !isOperand(code.operation) && code.operation != ExpressionOperation::PLUS;
+	});
+}
+
+const char* expressionErrorMessage(ExpressionError error)
+{
+	switch (error)
+	{
+		case ExpressionError::ARITHMETIC_OVERFLOW:
+		{
+			return "Arithmetic overflow";
+		}
+		case ExpressionError::DIVISION_BY_ZERO:
+		{
+			return "Division by zero";
+		}
+		default:
+		{
+			return "";
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+enum class ExpressionOperation : uint8_t
+{
+	NUMBER,
+	REGISTER,
+	CURRENT_ADDRESS,
+	START_ADDRESS,
+	PROGRAM_SIZE,
+
+	PLUS,
+	NEGATE,
+
+	ADD,
+	SUBTRACT,
+	MULTIPLY,
+	DIVIDE,
+	POWER,
+};
+
+enum class ExpressionError : uint8_t
+{
+	NONE,
+	ARITHMETIC_OVERFLOW,
+	DIVISION_BY_ZERO,
+};
+
+// One postfix instruction. Operands carry their value, registers their index
+struct ExpressionCode
+{
+	ExpressionOperation operation;
+	uint8_t size;
+	int64_t value;
+};
+
+struct ExpressionAddresses
+{
+	int64_t current;
+	int64_t start;
+};
+
+bool isOperand(ExpressionOperation operation);
+bool isUnaryOperation(ExpressionOperation operation);
+
+ExpressionError applyOperation(ExpressionOperation operation, int64_t left, int64_t right, int64_t& result);
+int64_t evaluateExpression(const ExpressionCode* begin, const ExpressionCode* end, const ExpressionAddresses& addresses, uint32_t line);
+ExpressionError tryEvaluateExpression(const ExpressionCode* begin, const ExpressionCode* end, const ExpressionAddresses& addresses, int64_t& result);
+bool usesAddress(const ExpressionCode* begin, const ExpressionCode* end);
+bool mayFail(const ExpressionCode* begin, const ExpressionCode* end);
+
+const char* expressionErrorMessage(ExpressionError error);
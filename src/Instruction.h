@@ -1,16 +1,216 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
 #include "Token.h"
+#include "Expression.h"
+#include "SourceFile.h"
+
+// An instruction operand. index is the register index for REGISTER and SEGMENT_REGISTER,
+// the symbol id for labels and GETOFFSET_OPERATOR, and the expression id for MEMORY_ADDRESSING
+// and arithmetic
+struct Operand
+{
+	TokenType type;
+	uint8_t size;
+	union
+	{
+		int32_t number;
+		uint32_t index;
+	};
+};
+
+struct DataString
+{
+	const char* data;
+	uint32_t size;
+};
+
+// amount and value are expression ids
+struct DataRepetition
+{
+	uint32_t amount;
+	uint32_t value;
+};
+
+// An item of a data defining instruction. DUPDATA_OPERATOR repeats the value expression amount times
+struct DataItem
+{
+	TokenType type;
+	uint32_t line;
+	union
+	{
+		int64_t number;
+		DataString string;
+		DataRepetition dup;
+	};
+};
 
-struct Node
+struct DataRange
 {
-	Token token;
-	std::shared_ptr<Node> left;
-	std::shared_ptr<Node> right;
+	uint32_t first;
+	uint32_t count;
 };
 
+// Instructions, label declarations and data definitions in source order.
+// mnemonic is the mnemonic id of an INSTRUCTION or the dataDefiningInstructions index of a data definition.
+// size is the item size of a data definition, and 2 on a jump to a label that branch relaxation made near
 struct Instruction
 {
-	Token token;
-	std::vector<Node> arguments;
-};
\ No newline at end of file
+	TokenType type;
+	uint8_t size;
+	uint8_t mnemonic;
+	uint8_t operandCount;
+	uint32_t line;
+	union
+	{
+		Operand operands[2];
+		DataRange data;
+		uint32_t symbol;
+	};
+};
+
+static_assert(sizeof(Operand) == 8 && sizeof(Instruction) == 24, "Instruction records are meant to stay compact");
+
+// Instruction records the code generator works on, held by the parser or by a mapped parse cache entry
+class InstructionSpan
+{
+	public:
+		InstructionSpan() = default;
+
+		InstructionSpan(Instruction* first, size_t count)
+		:first(first), count(count)
+		{
+		}
+
+		InstructionSpan(std::vector<Instruction>& instructions)
+		:first(instructions.data()), count(instructions.size())
+		{
+		}
+
+		size_t size() const
+		{
+			return count;
+		}
+
+		Instruction& operator[](size_t index) const
+		{
+			return first[index];
+		}
+	private:
+		Instruction* first = nullptr;
+		size_t count = 0;
+};
+
+// Expression bytecode, data items and included files of a whole parse, referenced by index and released together
+class ParseArena
+{
+	public:
+		uint32_t addExpression(const std::vector<ExpressionCode>& expression)
+		{
+			expressions.push_back({ (uint32_t)code.size(), (uint32_t)expression.size() });
+			code.insert(code.end(), expression.begin(), expression.end());
+			return (uint32_t)(expressions.size() - 1);
+		}
+
+		const ExpressionCode* expressionBegin(uint32_t expression) const
+		{
+			return codeData() + expressionData()[expression].first;
+		}
+
+		const ExpressionCode* expressionEnd(uint32_t expression) const
+		{
+			return codeData() + expressionData()[expression].first + expressionData()[expression].count;
+		}
+
+		void addData(const DataItem& item)
+		{
+			data.push_back(item);
+		}
+
+		uint32_t dataSize() const
+		{
+			return (uint32_t)data.size();
+		}
+
+		const DataItem* dataBegin(DataRange range) const
+		{
+			return dataItems() + range.first;
+		}
+
+		const DataItem* dataEnd(DataRange range) const
+		{
+			return dataItems() + range.first + range.count;
+		}
+
+		// Included files stay mapped while string items point into them. nullptr when the file can't be opened
+		const SourceFile* addFile(const std::filesystem::path& path)
+		{
+			files.push_back({ path, std::make_unique<SourceFile>(path) });
+			return files.back().file->isOpen() ? files.back().file.get() : nullptr;
+		}
+
+		size_t fileCount() const
+		{
+			return files.size();
+		}
+
+		const std::filesystem::path& filePath(size_t file) const
+		{
+			return files[file].path;
+		}
+
+		std::string_view fileContent(size_t file) const
+		{
+			return files[file].file->view();
+		}
+	private:
+		friend class ParseCache;
+
+		struct ExpressionRange
+		{
+			uint32_t first;
+			uint32_t count;
+		};
+
+		struct IncludedFile
+		{
+			std::filesystem::path path;
+			std::unique_ptr<SourceFile> file;
+		};
+
+		std::vector<ExpressionCode> code;
+		std::vector<ExpressionRange> expressions;
+		std::vector<DataItem> data;
+		std::vector<IncludedFile> files;
+		// The parse cache entry this arena was loaded from, if any. Its records are used where they are mapped
+		std::unique_ptr<SourceFile> cacheEntry;
+		const ExpressionCode* cachedCode = nullptr;
+		const ExpressionRange* cachedExpressions = nullptr;
+		const DataItem* cachedData = nullptr;
+
+		const ExpressionCode* codeData() const
+		{
+			return cacheEntry ? cachedCode : code.data();
+		}
+
+		const ExpressionRange* expressionData() const
+		{
+			return cacheEntry ? cachedExpressions : expressions.data();
+		}
+
+		const DataItem* dataItems() const
+		{
+			return cacheEntry ? cachedData : data.data();
+		}
+};
+
+// A run of instructions handed from the parser thread to the code generator, with the arena its indices refer to
+struct ParseBatch
+{
+	std::vector<Instruction> instructions;
+	ParseArena arena;
+};
@@ -1,14 +1,17 @@
 
 #include <iostream>
+#include <algorithm>
+#include <charconv>
 
 #include "Lexer.h"
-#include "registers.h"
-#include "instructionsSet.h"
-#include "toLower.h"
+#include "keywords.h"
+#include "characterClasses.h"
+#include "scan.h"
 #include "getNumberSize.h"
+#include "parallelFor.h"
 
-Lexer::Lexer(std::string source):
-source(source) 
+Lexer::Lexer(std::string_view source, uint32_t line):
+line(line), source(source) 
 {
 }
 
@@ -23,7 +26,7 @@ char Lexer::peek()
 	{
 		return '\0';
 	}
-	return source.at(current);
+	return source[current];
 }
 
 char Lexer::peekNext()
@@ -32,12 +35,12 @@ char Lexer::peekNext()
 	{
 		return '\0';
 	}
-	return source.at(current + 1);
+	return source[current + 1];
 }
 
 char Lexer::advance() 
 {
-	return source.at(current++);
+	return source[current++];
 }
 
 void Lexer::nextLine() 
@@ -45,19 +48,172 @@ void Lexer::nextLine()
 	line++;
 }
 
-std::vector<Token>& Lexer::tokenize()
+TokenStream& Lexer::tokenize()
+{
+	tokenizeChunk();
+	tokens.push({ TokenType::END_OF_FILE, TokenGroup::MAIN, line, 0, 0, "EOF"});
+	return tokens;
+}
+
+TokenStream& Lexer::tokenize(unsigned threadCount)
+{
+	size_t chunkCount = std::min<size_t>((size_t)threadCount * 4, source.size() / minimumChunkSize);
+
+	if (threadCount < 2 || chunkCount < 2)
+	{
+		return tokenize();
+	}
+
+	std::vector<std::string_view> chunks;
+	size_t chunkStart = 0;
+	for (size_t i = 1; i <= chunkCount && chunkStart < source.size(); i++)
+	{
+		size_t chunkEnd = source.size();
+		if (i < chunkCount)
+		{
+			size_t splitAt = std::max(chunkStart, source.size() / chunkCount * i);
+			chunkEnd = findNewline(source.data() + splitAt, source.data() + source.size()) - source.data();
+			chunkEnd = std::min(chunkEnd + 1, source.size());
+		}
+		chunks.push_back(source.substr(chunkStart, chunkEnd - chunkStart));
+		chunkStart = chunkEnd;
+	}
+
+	std::vector<size_t> chunkLines(chunks.size());
+	parallelFor(chunks.size(), threadCount, [&](size_t i)
+	{
+		chunkLines[i] = countNewlines(chunks[i].data(), chunks[i].data() + chunks[i].size());
+	});
+
+	size_t chunkLine = line;
+	for (auto& lines : chunkLines)
+	{
+		size_t newlines = lines;
+		lines = chunkLine;
+		chunkLine += newlines;
+	}
+
+	std::vector<TokenStream> chunkTokens(chunks.size());
+	parallelFor(chunks.size(), threadCount, [&](size_t i)
+	{
+		Lexer chunkLexer(chunks[i], (uint32_t)chunkLines[i]);
+		chunkLexer.tokenizeChunk();
+		chunkTokens[i] = std::move(chunkLexer.tokens);
+	});
+
+	size_t tokenCount = 1;
+	for (const auto& chunk : chunkTokens)
+	{
+		tokenCount += chunk.size();
+	}
+	tokens.reserve(tokenCount);
+
+	for (auto& chunk : chunkTokens)
+	{
+		// A chunk lexer cannot see the token before its first line, so a leading sign is re-decided here
+		if (!chunk.empty() && !tokens.empty() && chunk.type(0) == TokenType::ARITHMETIC_UNARY_OPERATOR && !expectsOperand(tokens.type(tokens.size() - 1)))
+		{
+			chunk.setType(0, TokenType::ARITHMETIC_BINARY_OPERATOR);
+		}
+		tokens.append(chunk);
+		chunk = {};
+	}
+
+	current = source.size();
+	line = (uint32_t)chunkLine;
+
+	tokens.push({ TokenType::END_OF_FILE, TokenGroup::MAIN, line, 0, 0, "EOF"});
+	return tokens;
+}
+
+// Lexes the source a few lines at a time and hands every chunk to the parser thread as soon as it is done.
+// The last chunk ends with END_OF_FILE. Returns the number of tokens before it
+size_t Lexer::tokenize(SpscQueue<TokenStream>& queue)
+{
+	size_t tokenCount = 0;
+	TokenType previous = TokenType::NONE;
+
+	while (current < source.size())
+	{
+		size_t chunkEnd = std::min(current + streamChunkSize, source.size());
+		chunkEnd = std::min<size_t>(findNewline(source.data() + chunkEnd, source.data() + source.size()) - source.data() + 1, source.size());
+
+		Lexer chunkLexer(source.substr(current, chunkEnd - current), line);
+		chunkLexer.expectsFileName = expectsFileName;
+		chunkLexer.tokenizeChunk();
+		current = chunkEnd;
+		line = chunkLexer.line;
+		expectsFileName = chunkLexer.expectsFileName;
+
+		TokenStream& chunk = chunkLexer.tokens;
+		if (chunk.empty())
+		{
+			continue;
+		}
+		if (previous != TokenType::NONE && chunk.type(0) == TokenType::ARITHMETIC_UNARY_OPERATOR && !expectsOperand(previous))
+		{
+			chunk.setType(0, TokenType::ARITHMETIC_BINARY_OPERATOR);
+		}
+		previous = chunk.type(chunk.size() - 1);
+		tokenCount += chunk.size();
+
+		queue.push(std::move(chunk));
+	}
+
+	TokenStream end;
+	end.push({ TokenType::END_OF_FILE, TokenGroup::MAIN, line, 0, 0, "EOF"});
+	queue.push(std::move(end));
+
+	return tokenCount;
+}
+
+// Lexes only as far as needed to return the next token, so the whole token stream is never held.
+// Returns END_OF_FILE once the source is used up
+Token Lexer::next()
+{
+	while (pending == tokens.size())
+	{
+		if (!tokens.empty())
+		{
+			previousType = tokens.type(tokens.size() - 1);
+			tokens.clear();
+			pending = 0;
+		}
+		if (isEnd())
+		{
+			tokens.push({ TokenType::END_OF_FILE, TokenGroup::MAIN, line, 0, 0, "EOF"});
+			return tokens[pending++];
+		}
+		tokenStart = current;
+		nextToken();
+	}
+
+	tokensRead++;
+	return tokens[pending++];
+}
+
+size_t Lexer::tokenCount() const
+{
+	return tokensRead;
+}
+
+const SymbolTable& Lexer::symbols() const
+{
+	return tokens.symbols();
+}
+
+void Lexer::tokenizeChunk()
 {
 	while(!isEnd()) 
 	{
 		tokenStart = current;
 		nextToken();
 	}
-	tokens.push_back({ TokenType::END_OF_FILE, TokenGroup::MAIN, line, 0, 0, "EOF"});
-	return tokens;
 }
 
 void Lexer::nextToken() 
 {
+	size_t tokensBefore = tokens.size();
 	char c = advance();
 	switch (c)
 	{
@@ -65,6 +221,10 @@ void Lexer::nextToken()
 		case '\r':
 		case '\t': 
 		{
+			while (!isEnd() && hasCharacterClass(source[current], WHITESPACE))
+			{
+				current++;
+			}
 			break;
 		}
 		case '\n': 
@@ -74,103 +234,103 @@ void Lexer::nextToken()
 		}
 		case '+': 
 		{
-			if (tokens.size() == 0 || tokens.back().type == TokenType::ARITHMETIC_BINARY_OPERATOR || tokens.back().type == TokenType::ARITHMETIC_UNARY_OPERATOR || tokens.back().type == TokenType::LEFT_PAREN || tokens.back().type == TokenType::COMMA || tokens.back().type == TokenType::INSTRUCTION || tokens.back().type == TokenType::DATA_DEFINING_INSTRUCTION)
+			if (isOperandExpected())
 			{
-				tokens.push_back({ TokenType::ARITHMETIC_UNARY_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "+" });
+				tokens.push({ TokenType::ARITHMETIC_UNARY_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "+" });
 			}
 			else
 			{
-				tokens.push_back({ TokenType::ARITHMETIC_BINARY_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 2, "+" });
+				tokens.push({ TokenType::ARITHMETIC_BINARY_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 2, "+" });
 			}
 			break;
 		}
 		case '-':
 		{
-			if (tokens.size() == 0 || tokens.back().type == TokenType::ARITHMETIC_BINARY_OPERATOR || tokens.back().type == TokenType::ARITHMETIC_UNARY_OPERATOR || tokens.back().type == TokenType::LEFT_PAREN || tokens.back().type == TokenType::COMMA || tokens.back().type == TokenType::INSTRUCTION || tokens.back().type == TokenType::DATA_DEFINING_INSTRUCTION)
+			if (isOperandExpected())
 			{
-				tokens.push_back({ TokenType::ARITHMETIC_UNARY_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "-" });
+				tokens.push({ TokenType::ARITHMETIC_UNARY_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "-" });
 			}
 			else
 			{
-				tokens.push_back({ TokenType::ARITHMETIC_BINARY_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 2, "-" });
+				tokens.push({ TokenType::ARITHMETIC_BINARY_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 2, "-" });
 			}
 			break;
 		}
 		case '*':
 		{
-			tokens.push_back({ TokenType::ARITHMETIC_BINARY_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 1, "*" });
+			tokens.push({ TokenType::ARITHMETIC_BINARY_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 1, "*" });
 			break;
 		}
 		case '/':
 		{
-			tokens.push_back({ TokenType::ARITHMETIC_BINARY_OPERATOR, TokenGroup::ADDITIONAL,line, 0, 1, "/" });
+			tokens.push({ TokenType::ARITHMETIC_BINARY_OPERATOR, TokenGroup::ADDITIONAL,line, 0, 1, "/" });
 			break;
 		}
 		case '^':
 		{
-			tokens.push_back({ TokenType::ARITHMETIC_BINARY_OPERATOR, TokenGroup::ADDITIONAL,line, 0, 0, "^" });
+			tokens.push({ TokenType::ARITHMETIC_BINARY_OPERATOR, TokenGroup::ADDITIONAL,line, 0, 0, "^" });
 			break;
 		}
 		case '(': 
 		{
-			tokens.push_back({ TokenType::LEFT_PAREN, TokenGroup::ADDITIONAL, line, 0, 0, "(" });
+			tokens.push({ TokenType::LEFT_PAREN, TokenGroup::ADDITIONAL, line, 0, 0, "(" });
 			break;
 		}
 		case ')':
 		{
-			tokens.push_back({ TokenType::RIGHT_PAREN, TokenGroup::ADDITIONAL, line, 0, 0, ")" });
+			tokens.push({ TokenType::RIGHT_PAREN, TokenGroup::ADDITIONAL, line, 0, 0, ")" });
 			break;
 		}
 		case '[':
 		{
-			tokens.push_back({ TokenType::LEFT_BRACKET, TokenGroup::ADDITIONAL, line, 0, 0, "[" });
+			tokens.push({ TokenType::LEFT_BRACKET, TokenGroup::ADDITIONAL, line, 0, 0, "[" });
 			break;
 		}
 		case ']':
 		{
-			tokens.push_back({ TokenType::RIGHT_BRACKET, TokenGroup::ADDITIONAL, line, 0, 0, "]" });
+			tokens.push({ TokenType::RIGHT_BRACKET, TokenGroup::ADDITIONAL, line, 0, 0, "]" });
 			break;
 		}
 		case '&':
 		{
-			tokens.push_back({ TokenType::GETOFFSET_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "&" });
+			tokens.push({ TokenType::GETOFFSET_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "&" });
 			break;
 		}
 		case '#': 
 		{
-			tokens.push_back({ TokenType::GETPROGRAMSIZE_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "#" });
+			tokens.push({ TokenType::GETPROGRAMSIZE_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "#" });
 			break;
 		}
 		case '$':
 		{
 			if (peekNext() == '$') 
 			{
-				tokens.push_back({ TokenType::GETSTARTADDRESS_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "$$" });
+				tokens.push({ TokenType::GETSTARTADDRESS_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "$$" });
 			}
 			else 
 			{
-				tokens.push_back({ TokenType::GETCURRENTADDRESS_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "$" });
+				tokens.push({ TokenType::GETCURRENTADDRESS_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "$" });
 			}
 			break;
 		}
 		case '@': 
 		{
-			tokens.push_back({ TokenType::DUPDATA_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "@" });
+			tokens.push({ TokenType::DUPDATA_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "@" });
 			break;
 		}
 		case '=':
 		{
-			tokens.push_back({ TokenType::EQUAL_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "=" });
+			tokens.push({ TokenType::EQUAL_OPERATOR, TokenGroup::ADDITIONAL, line, 0, 0, "=" });
 			break;
 		}
 		case '%':
 		{
-			tokens.push_back({ TokenType::DEFINECTCONSTANT_OPERATOR, TokenGroup::MAIN, line, 0, 0, "%" });
+			tokens.push({ TokenType::DEFINECTCONSTANT_OPERATOR, TokenGroup::MAIN, line, 0, 0, "%" });
 			break;
 		}
 		case ',':
 		{
-			tokens.push_back({ TokenType::COMMA, TokenGroup::ADDITIONAL, line, 0, 0, "," });
+			tokens.push({ TokenType::COMMA, TokenGroup::ADDITIONAL, line, 0, 0, "," });
 			break;
 		}
 		case '\'':
@@ -197,14 +357,17 @@ void Lexer::nextToken()
 			break;
 		}
 	}
+
+	if (tokens.size() != tokensBefore)
+	{
+		expectsFileName = tokens.type(tokens.size() - 1) == TokenType::DATA_DEFINING_INSTRUCTION
+			&& dataDefiningInstructions[tokens[tokens.size() - 1].numberValue].kind == DataDefinitionKind::INCLUSION;
+	}
 }
 
 void Lexer::comment()
 {
-	while (peek() != '\n' && !isEnd())
-	{
-		advance();
-	}
+	current = (size_t)(findNewline(source.data() + current, source.data() + source.size()) - source.data());
 }
 
 void Lexer::makeNumber() 
@@ -214,27 +377,28 @@ void Lexer::makeNumber()
 		advance();
 	}
 
-	std::string numberString = source.substr(tokenStart, current - tokenStart);
-	int64_t number;
+	std::string_view numberString = source.substr(tokenStart, current - tokenStart);
+	int64_t number = 0;
+	std::from_chars_result result;
 	char base = peek();
 
 	switch(base) 
 	{
 		case 'b': 
 		{
-			number = std::strtoll(numberString.c_str(), nullptr, 2);
+			result = std::from_chars(numberString.data(), numberString.data() + numberString.size(), number, 2);
 			advance();
 			break;
 		}
 		case 'q': 
 		{
-			number = std::strtoll(numberString.c_str(), nullptr, 8);
+			result = std::from_chars(numberString.data(), numberString.data() + numberString.size(), number, 8);
 			advance();
 			break;
 		}
 		case 'h': 
 		{
-			number = std::strtoll(numberString.c_str(), nullptr, 16);
+			result = std::from_chars(numberString.data(), numberString.data() + numberString.size(), number, 16);
 			advance();
 			break;
 		}
@@ -242,23 +406,23 @@ void Lexer::makeNumber()
 		{
 			if (numberString.back() == 'b')
 			{
-				numberString.pop_back();
-				number = std::strtoll(numberString.c_str(), nullptr, 2);
+				numberString.remove_suffix(1);
+				result = std::from_chars(numberString.data(), numberString.data() + numberString.size(), number, 2);
 			}
 			else
 			{
-				number = std::strtoll(numberString.c_str(), nullptr, 10);
+				result = std::from_chars(numberString.data(), numberString.data() + numberString.size(), number, 10);
 			}
 			break;
 		}
 	}
-	if (number == LLONG_MIN || number == LLONG_MAX)
+	if (result.ec == std::errc::result_out_of_range)
 	{
-		error(line, "Bad number: " + numberString);
+		error(line, "Bad number: " + std::string(numberString));
 	}
 	else 
 	{
-		tokens.push_back({ TokenType::NUMBER, TokenGroup::ADDITIONAL, line, getNumberSize(number), number, numberString + base });
+		tokens.push({ TokenType::NUMBER, TokenGroup::ADDITIONAL, line, getNumberSize(number), number, source.substr(tokenStart, current - tokenStart) });
 	}
 }
 
@@ -274,14 +438,16 @@ void Lexer::makeString()
 		error(line, "Unterminated string");
 	}
 
-	c = peek();
+	std::string_view string = source.substr(tokenStart + 1, current - tokenStart - 2);
 
-	std::string string = source.substr(tokenStart + 1, current - tokenStart - 2);
-
-	for (const auto& c : string) 
+	// A single character is a character constant usable in expressions, unless it names the file of incbin
+	if (string.size() == 1 && !expectsFileName)
 	{
-		tokens.push_back({ TokenType::NUMBER, TokenGroup::ADDITIONAL, line, 1, c, std::string(c, 1) });
-		tokens.push_back({ TokenType::COMMA, TokenGroup::ADDITIONAL, line, 0, 0, "," });
+		tokens.push({ TokenType::NUMBER, TokenGroup::ADDITIONAL, line, 1, string[0], string });
+	}
+	else
+	{
+		tokens.push({ TokenType::STRING, TokenGroup::ADDITIONAL, line, 0, 0, string });
 	}
 }
 
@@ -292,24 +458,25 @@ void Lexer::makeKeywordIdentifier()
 		advance();
 	}
 
-	std::string identifierString = source.substr(tokenStart, current - tokenStart);
-	std::string identifierStringLower = toLowerCopy(identifierString);
+	std::string_view identifierString = source.substr(tokenStart, current - tokenStart);
+	const Keyword* keyword = findKeyword(identifierString);
+	KeywordType keywordType = keyword ? keyword->type : KeywordType::NONE;
 
-	if (const auto it = registers.find(identifierStringLower); it != registers.end())
+	if (keywordType == KeywordType::REGISTER)
 	{
-		makeRegister(identifierStringLower, it->second.size, it->second.index);
+		makeRegister(keyword->name, keyword->size, keyword->index);
 	}
-	else if (const auto it = segmentRegisters.find(identifierStringLower); it != segmentRegisters.end())
+	else if (keywordType == KeywordType::SEGMENT_REGISTER)
 	{
-		makeSegmentRegister(identifierStringLower, it->second.size, it->second.index);
+		makeSegmentRegister(keyword->name, keyword->size, keyword->index);
 	}
-	else if (const auto it = dataDefiningInstructions.find(identifierStringLower); it != dataDefiningInstructions.end()) {
-		makeDataDefiningInstruction(it->first, it->second);
+	else if (keywordType == KeywordType::DATA_DEFINING_INSTRUCTION) {
+		makeDataDefiningInstruction(keyword->name, keyword->size, keyword->index);
 	}
 	else if (!isEnd() && peek() == ':') 
 	{
 		advance();
-		if (source.at(tokenStart) == '.')
+		if (source[tokenStart] == '.')
 		{
 			makeLocalLabelDeclaration(identifierString);
 		} 
@@ -318,11 +485,11 @@ void Lexer::makeKeywordIdentifier()
 			makeGlobalLabelDeclaration(identifierString);
 		}
 	}
-	else if (checkInstuction(identifierStringLower)) 
+	else if (keywordType == KeywordType::INSTRUCTION) 
 	{
-		makeInstruction(identifierStringLower);
+		makeInstruction(keyword->name, keyword->index);
 	}
-	else if (source.at(tokenStart) == '.') 
+	else if (source[tokenStart] == '.') 
 	{
 		makeLocalLabel(identifierString);
 	}
@@ -332,75 +499,86 @@ void Lexer::makeKeywordIdentifier()
 	}
 }
 
-void Lexer::makeRegister(const std::string &name, uint8_t size, uint8_t index)
+void Lexer::makeRegister(std::string_view name, uint8_t size, uint8_t index)
+{
+	tokens.push({ TokenType::REGISTER, TokenGroup::ADDITIONAL, line, size, index, name });
+}
+
+void Lexer::makeSegmentRegister(std::string_view name, uint8_t size, uint8_t index)
+{
+	tokens.push({ TokenType::SEGMENT_REGISTER, TokenGroup::ADDITIONAL, line, size, index, name });
+}
+
+void Lexer::makeGlobalLabelDeclaration(std::string_view name)
 {
-	tokens.push_back({ TokenType::REGISTER, TokenGroup::ADDITIONAL, line, size, index, name });
+	tokens.push({ TokenType::GLOBAL_LABEL_DECLARATION, TokenGroup::MAIN, line, (uint8_t)name.size() , tokens.symbols().intern(name), name });
 }
 
-void Lexer::makeSegmentRegister(const std::string& name, uint8_t size, uint8_t index)
+void Lexer::makeLocalLabelDeclaration(std::string_view name)
 {
-	tokens.push_back({ TokenType::SEGMENT_REGISTER, TokenGroup::ADDITIONAL, line, size, index, name });
+	tokens.push({ TokenType::LOCAL_LABEL_DECLARATION, TokenGroup::MAIN, line, (uint8_t)name.size() , tokens.symbols().intern(name), name });
 }
 
-void Lexer::makeGlobalLabelDeclaration(const std::string& name)
+void Lexer::makeGlobalLabel(std::string_view name)
 {
-	tokens.push_back({ TokenType::GLOBAL_LABEL_DECLARATION, TokenGroup::MAIN, line, (uint8_t)name.size() , NULL, name });
+	tokens.push({ TokenType::GLOBAL_LABEL, TokenGroup::ADDITIONAL, line, (uint8_t)name.size() , tokens.symbols().intern(name), name });
 }
 
-void Lexer::makeLocalLabelDeclaration(const std::string& name)
+void Lexer::makeLocalLabel(std::string_view name)
 {
-	tokens.push_back({ TokenType::LOCAL_LABEL_DECLARATION, TokenGroup::MAIN, line, (uint8_t)name.size() , NULL, name });
+	tokens.push({ TokenType::LOCAL_LABEL,  TokenGroup::ADDITIONAL, line, (uint8_t)name.size() , tokens.symbols().intern(name), name });
 }
 
-void Lexer::makeGlobalLabel(const std::string &name)
+void Lexer::makeInstruction(std::string_view name, uint8_t id)
 {
-	tokens.push_back({ TokenType::GLOBAL_LABEL, TokenGroup::ADDITIONAL, line, (uint8_t)name.size() , NULL, name });
+	tokens.push({ TokenType::INSTRUCTION, TokenGroup::MAIN, line, 0 , id, name });
 }
 
-void Lexer::makeLocalLabel(const std::string& name)
+void Lexer::makeDataDefiningInstruction(std::string_view name, uint8_t size, uint8_t index)
 {
-	tokens.push_back({ TokenType::LOCAL_LABEL,  TokenGroup::ADDITIONAL, line, (uint8_t)name.size() , NULL, name });
+	tokens.push({ TokenType::DATA_DEFINING_INSTRUCTION, TokenGroup::MAIN, line, size , index, name });
 }
 
-void Lexer::makeInstruction(const std::string& name)
+bool Lexer::isOperandExpected()
 {
-	tokens.push_back({ TokenType::INSTRUCTION, TokenGroup::MAIN, line, 0 , NULL, name });
+	TokenType previous = tokens.empty() ? previousType : tokens.type(tokens.size() - 1);
+	return previous == TokenType::NONE || expectsOperand(previous);
 }
 
-void Lexer::makeDataDefiningInstruction(const std::string& name, uint8_t size)
+bool Lexer::expectsOperand(TokenType previous)
 {
-	tokens.push_back({ TokenType::DATA_DEFINING_INSTRUCTION, TokenGroup::MAIN, line, size , NULL, name });
+	return previous == TokenType::ARITHMETIC_BINARY_OPERATOR || previous == TokenType::ARITHMETIC_UNARY_OPERATOR || previous == TokenType::LEFT_PAREN || previous == TokenType::COMMA || previous == TokenType::INSTRUCTION || previous == TokenType::DATA_DEFINING_INSTRUCTION;
 }
 
 bool Lexer::isDigit(char c)
 {
-	return c >= '0' && c <= '9';
+	return hasCharacterClass(c, DIGIT);
 }
 
 bool Lexer::isBinaryDigit(char c)
 {
-	return c == '0' || c == '1';
+	return hasCharacterClass(c, BINARY_DIGIT);
 }
 
 bool Lexer::isOctalDigit(char c)
 {
-	return c >= '0' && c <= '8';
+	return hasCharacterClass(c, OCTAL_DIGIT);
 }
 
 bool Lexer::isHexDigit(char c)
 {
-	return isDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+	return hasCharacterClass(c, HEX_DIGIT);
 }
 
 bool Lexer::isAlpha(char c) {
-	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+	return hasCharacterClass(c, ALPHA);
 }
 
 bool Lexer::isAlphaNumeric(char c) {
-	return isDigit(c) || isAlpha(c);
+	return hasCharacterClass(c, DIGIT | ALPHA);
 }
 
-void Lexer::error(uint16_t line, const std::string &message)
+void Lexer::error(uint32_t line, const std::string &message)
 {
 	std::cout << "Line " << line << ": " << message << '\n';
 	exit(-1);
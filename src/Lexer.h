@@ -1,23 +1,43 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "Token.h"
+#include "TokenStream.h"
+#include "SpscQueue.h"
 
 class Lexer 
 {
 	public:
-		Lexer(std::string source);
-		std::vector<Token>& tokenize();
+		Lexer(std::string_view source, uint32_t line = 1);
+		TokenStream& tokenize();
+		TokenStream& tokenize(unsigned threadCount);
+		size_t tokenize(SpscQueue<TokenStream>& queue);
+
+		Token next();
+		size_t tokenCount() const;
+		const SymbolTable& symbols() const;
 	private:
-		std::vector<Token> tokens;
+		static constexpr size_t minimumChunkSize = 1 << 20;
+		static constexpr size_t streamChunkSize = 1 << 16;
+
+		TokenStream tokens;
+
+		// next() hands out tokens from the front of tokens and clears it once all of them are read
+		size_t pending = 0;
+		size_t tokensRead = 0;
+		TokenType previousType = TokenType::NONE;
 
-		uint16_t line = 1;
-		uint16_t tokenStart = 0;
-		uint16_t current = 0;
+		// Whether the last token was incbin, whose file name stays a string even when it is a single character
+		bool expectsFileName = false;
 
-		std::string source;
+		uint32_t line = 1;
+		size_t tokenStart = 0;
+		size_t current = 0;
+
+		std::string_view source;
 
 		bool isEnd();
 		char peek();
@@ -25,6 +45,8 @@ class Lexer
 		char advance();
 		void nextLine();
 		void nextToken();
+		void tokenizeChunk();
+		bool isOperandExpected();
 
 		void comment();
 
@@ -33,14 +55,16 @@ class Lexer
 		void makeString();
 
 		void makeKeywordIdentifier();
-		void makeRegister(const std::string& name, uint8_t size, uint8_t index);
-		void makeSegmentRegister(const std::string& name, uint8_t size, uint8_t index);
-		void makeGlobalLabel(const std::string& name);
-		void makeLocalLabel(const std::string& name);
-		void makeGlobalLabelDeclaration(const std::string& name);
-		void makeLocalLabelDeclaration(const std::string& name);
-		void makeInstruction(const std::string& name);
-		void makeDataDefiningInstruction(const std::string& name, uint8_t size);
+		void makeRegister(std::string_view name, uint8_t size, uint8_t index);
+		void makeSegmentRegister(std::string_view name, uint8_t size, uint8_t index);
+		void makeGlobalLabel(std::string_view name);
+		void makeLocalLabel(std::string_view name);
+		void makeGlobalLabelDeclaration(std::string_view name);
+		void makeLocalLabelDeclaration(std::string_view name);
+		void makeInstruction(std::string_view name, uint8_t id);
+		void makeDataDefiningInstruction(std::string_view name, uint8_t size, uint8_t index);
+
+		static bool expectsOperand(TokenType previous);
 
 		static bool isDigit(char c);
 		static bool isBinaryDigit(char c);
@@ -49,5 +73,5 @@ class Lexer
 		static bool isAlpha(char c);
 		static bool isAlphaNumeric(char c);
 
-		static void error(uint16_t line, const std::string& message);
+		static void error(uint32_t line, const std::string& message);
 };
\ No newline at end of file
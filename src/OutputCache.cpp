@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "OutputCache.h"
+#include "SourceFile.h"
+#include "contentHash.h"
+#include "writeSparse.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+static constexpr std::string_view manifestMagic = "8086 assembler output manifest";
+
+static uint64_t combineHashes(const std::vector<uint64_t>& hashes)
+{
+	return contentHash({ (const char*)hashes.data(), hashes.size() * sizeof(uint64_t) });
+}
+
+// Shares the blocks of from where the file system supports it. Otherwise they are copied, leaving out zero blocks
+// so the copy stays as sparse as the output it was made from
+static bool cloneFile(const std::filesystem::path& from, const std::filesystem::path& to)
+{
+#if defined(__linux__) && defined(FICLONE)
+	int source = ::open(from.c_str(), O_RDONLY);
+	if (source >= 0)
+	{
+		int destination = ::open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+		bool cloned = destination >= 0 && ioctl(destination, FICLONE, source) == 0;
+		if (destination >= 0)
+		{
+			close(destination);
+		}
+		close(source);
+		if (cloned)
+		{
+			return true;
+		}
+	}
+#endif
+
+	SourceFile content(from);
+	if (!content.isOpen())
+	{
+		return false;
+	}
+	std::ofstream file(to, std::ios::binary);
+	return file.is_open() && writeSparse(file, to, content.view());
+}
+
+// Written next to the target and renamed over it, so a concurrent run never sees a partial file
+static void replaceFile(const std::filesystem::path& path, const std::function<bool(const std::filesystem::path&)>& write)
+{
+	std::filesystem::path temporaryPath = path;
+	temporaryPath += "." + std::to_string(std::random_device()());
+
+	std::error_code error;
+	if (write(temporaryPath))
+	{
+		std::filesystem::rename(temporaryPath, path, error);
+		if (!error)
+		{
+			return;
+		}
+	}
+	std::filesystem::remove(temporaryPath, error);
+}
+
+OutputCache::OutputCache(const std::filesystem::path& directory, std::string_view source, uint64_t build, bool optimizesSize)
+:directory(directory)
+{
+	sourceHash = combineHashes({ contentHash(source, build), optimizesSize });
+}
+
+std::filesystem::path OutputCache::manifestPath() const
+{
+	return directory / (hashToHex(sourceHash) + ".manifest");
+}
+
+std::filesystem::path OutputCache::outputEntryPath(uint64_t hash) const
+{
+	return directory / (hashToHex(hash) + ".bin");
+}
+
+bool OutputCache::load(const std::filesystem::path& outputPath) const
+{
+	std::ifstream manifest(manifestPath());
+	std::string line;
+	if (!std::getline(manifest, line) || line != manifestMagic)
+	{
+		return false;
+	}
+
+	std::vector<uint64_t> hashes = { sourceHash };
+	while (std::getline(manifest, line))
+	{
+		SourceFile included(line);
+		if (!included.isOpen())
+		{
+			return false;
+		}
+		hashes.push_back(contentHash(included.view()));
+	}
+
+	std::filesystem::path entryPath = outputEntryPath(combineHashes(hashes));
+	std::error_code error;
+	return std::filesystem::is_regular_file(entryPath, error) && cloneFile(entryPath, outputPath);
+}
+
+void OutputCache::store(const std::filesystem::path& outputPath, const ParseArena& arena) const
+{
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+
+	// A file included more than once is listed once
+	std::vector<uint64_t> hashes = { sourceHash };
+	std::vector<std::filesystem::path> paths;
+	std::string manifest(manifestMagic);
+	for (size_t file = 0; file < arena.fileCount(); file++)
+	{
+		if (std::find(paths.begin(), paths.end(), arena.filePath(file)) != paths.end())
+		{
+			continue;
+		}
+		paths.push_back(arena.filePath(file));
+		hashes.push_back(contentHash(arena.fileContent(file)));
+		manifest += '\n' + arena.filePath(file).string();
+	}
+
+	replaceFile(outputEntryPath(combineHashes(hashes)), [&](const std::filesystem::path& path)
+	{
+		return cloneFile(outputPath, path);
+	});
+	replaceFile(manifestPath(), [&](const std::filesystem::path& path)
+	{
+		std::ofstream file(path, std::ios::binary);
+		file << manifest << '\n';
+		file.close();
+		return !file.fail();
+	});
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+#include "Instruction.h"
+
+// Assembled programs of earlier runs, kept in a directory under the hash of everything the output depends on:
+// the source, the files it includes, the options that change the encoding and the assembler build. Which files
+// a source includes is only known after parsing, so a manifest under the source hash lists them and the
+// output is found under the hash of the source together with their contents
+class OutputCache
+{
+	public:
+		OutputCache(const std::filesystem::path& directory, std::string_view source, uint64_t build, bool optimizesSize);
+
+		bool load(const std::filesystem::path& outputPath) const;
+		void store(const std::filesystem::path& outputPath, const ParseArena& arena) const;
+	private:
+		std::filesystem::path directory;
+		uint64_t sourceHash;
+
+		std::filesystem::path manifestPath() const;
+		std::filesystem::path outputEntryPath(uint64_t hash) const;
+};
@@ -0,0 +1,273 @@
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+
+#include "ParseCache.h"
+#include "contentHash.h"
+
+struct ParseCacheHeader
+{
+	uint64_t magic;
+	uint64_t sourceHash;
+	uint64_t sourceSize;
+	uint32_t instructionCount;
+	uint32_t codeCount;
+	uint32_t expressionCount;
+	uint32_t dataCount;
+	uint32_t symbolCount;
+	uint32_t fileCount;
+	uint32_t inclusionCount;
+	uint32_t stringsSize;
+};
+
+struct CachedString
+{
+	uint32_t offset;
+	uint32_t size;
+};
+
+struct CachedFile
+{
+	uint64_t hash;
+	CachedString path;
+};
+
+// A string item whose bytes are in an included file rather than the string section, in item order
+struct CachedInclusion
+{
+	uint32_t item;
+	uint32_t file;
+};
+
+// The record layouts are part of the format, so they are part of the magic as well
+static constexpr uint64_t magic = 0x5041525345000000ull | (uint64_t)sizeof(Instruction) << 16 | (uint64_t)sizeof(DataItem) << 8 | sizeof(ExpressionCode);
+
+ParseCache::ParseCache(const std::filesystem::path& directory, std::string_view source, uint64_t build)
+{
+	sourceHash = contentHash(source, build);
+	sourceSize = source.size();
+	path = directory / (hashToHex(sourceHash) + ".parse");
+}
+
+// Takes the next count records of the entry in place and moves past them
+template <typename T>
+static T* mapRecords(char*& p, size_t count)
+{
+	T* records = reinterpret_cast<T*>(p);
+	p += count * sizeof(T);
+	return records;
+}
+
+// The records are used where they are mapped rather than copied out. The mapping is copy-on-write, since string
+// items get their pointers back and code generation writes relaxed jump sizes into the instructions
+bool ParseCache::load(InstructionSpan& instructions, ParseArena& arena, SymbolTable& symbols) const
+{
+	static_assert(sizeof(ParseCacheHeader) % 8 == 0 && sizeof(Instruction) % 8 == 0 && sizeof(ExpressionCode) % 8 == 0
+		&& sizeof(ParseArena::ExpressionRange) % 8 == 0 && sizeof(DataItem) % 8 == 0, "Every section of an entry has to stay aligned");
+
+	auto cache = std::make_unique<SourceFile>(path, true);
+	if (!cache->isOpen())
+	{
+		return false;
+	}
+
+	std::string_view image = cache->view();
+	ParseCacheHeader header;
+	if (image.size() < sizeof(header))
+	{
+		return false;
+	}
+	memcpy(&header, image.data(), sizeof(header));
+
+	uint64_t expectedSize = sizeof(header) + header.instructionCount * sizeof(Instruction) + header.codeCount * sizeof(ExpressionCode)
+		+ header.expressionCount * sizeof(ParseArena::ExpressionRange) + header.dataCount * sizeof(DataItem)
+		+ header.symbolCount * sizeof(CachedString) + header.fileCount * sizeof(CachedFile) + header.inclusionCount * sizeof(CachedInclusion)
+		+ header.stringsSize;
+	if (header.magic != magic || header.sourceHash != sourceHash || header.sourceSize != sourceSize || image.size() != expectedSize)
+	{
+		return false;
+	}
+
+	const char* strings = image.data() + image.size() - header.stringsSize;
+	auto toString = [&](const CachedString& string)
+	{
+		return (uint64_t)string.offset + string.size <= header.stringsSize ? std::string_view(strings + string.offset, string.size) : std::string_view();
+	};
+
+	std::vector<ParseArena::IncludedFile> files;
+	const char* p = strings - header.inclusionCount * sizeof(CachedInclusion) - header.fileCount * sizeof(CachedFile);
+	for (uint32_t i = 0; i < header.fileCount; i++, p += sizeof(CachedFile))
+	{
+		CachedFile file;
+		memcpy(&file, p, sizeof(file));
+		std::filesystem::path filePath(std::string(toString(file.path)));
+		auto included = std::make_unique<SourceFile>(filePath);
+		if (!included->isOpen() || contentHash(included->view()) != file.hash)
+		{
+			return false;
+		}
+		files.push_back({ filePath, std::move(included) });
+	}
+
+	char* records = cache->writableData() + sizeof(header);
+	Instruction* cachedInstructions = mapRecords<Instruction>(records, header.instructionCount);
+	const ExpressionCode* code = mapRecords<ExpressionCode>(records, header.codeCount);
+	const ParseArena::ExpressionRange* expressions = mapRecords<ParseArena::ExpressionRange>(records, header.expressionCount);
+	DataItem* data = mapRecords<DataItem>(records, header.dataCount);
+
+	// String items hold offsets in place of their pointer, into the included file for incbin and into the string section otherwise
+	std::vector<CachedInclusion> inclusions(header.inclusionCount);
+	memcpy(inclusions.data(), p, inclusions.size() * sizeof(CachedInclusion));
+	size_t inclusion = 0;
+	for (uint32_t i = 0; i < header.dataCount; i++)
+	{
+		DataItem& item = data[i];
+		if (item.type != TokenType::STRING)
+		{
+			continue;
+		}
+
+		std::string_view content(strings, header.stringsSize);
+		if (inclusion < inclusions.size() && inclusions[inclusion].item == i)
+		{
+			if (inclusions[inclusion].file >= files.size())
+			{
+				return false;
+			}
+			content = files[inclusions[inclusion++].file].file->view();
+		}
+
+		uintptr_t offset = reinterpret_cast<uintptr_t>(item.string.data);
+		if ((uint64_t)offset + item.string.size > content.size())
+		{
+			return false;
+		}
+		item.string.data = content.data() + offset;
+	}
+	if (inclusion != inclusions.size())
+	{
+		return false;
+	}
+
+	// The ids are known already, so the names are not interned again
+	std::vector<std::string_view> names;
+	names.reserve(header.symbolCount);
+	for (uint32_t i = 0; i < header.symbolCount; i++, records += sizeof(CachedString))
+	{
+		CachedString name;
+		memcpy(&name, records, sizeof(name));
+		names.push_back(toString(name));
+	}
+	symbols = SymbolTable(std::move(names));
+
+	// Everything above points into the entry, so it stays mapped as long as the arena
+	instructions = InstructionSpan(cachedInstructions, header.instructionCount);
+	arena.cachedCode = code;
+	arena.cachedExpressions = expressions;
+	arena.cachedData = data;
+	arena.files = std::move(files);
+	arena.cacheEntry = std::move(cache);
+	return true;
+}
+
+void ParseCache::store(const std::vector<Instruction>& instructions, const ParseArena& arena, const SymbolTable& symbols) const
+{
+	std::string strings;
+	auto addString = [&](std::string_view string)
+	{
+		CachedString cached{ (uint32_t)strings.size(), (uint32_t)string.size() };
+		strings.append(string);
+		return cached;
+	};
+
+	// incbin bytes are read from the included file again on load, so only where they start in it is stored
+	auto findInclusion = [&](const DataString& string, uintptr_t& offset)
+	{
+		for (uint32_t file = 0; file < arena.files.size(); file++)
+		{
+			std::string_view content = arena.files[file].file->view();
+			if (!content.empty() && string.data >= content.data() && string.data + string.size <= content.data() + content.size())
+			{
+				offset = (uintptr_t)(string.data - content.data());
+				return file;
+			}
+		}
+		return UINT32_MAX;
+	};
+
+	std::vector<DataItem> data = arena.data;
+	std::vector<CachedInclusion> inclusions;
+	for (uint32_t i = 0; i < data.size(); i++)
+	{
+		DataItem& item = data[i];
+		if (item.type != TokenType::STRING)
+		{
+			continue;
+		}
+
+		uintptr_t offset;
+		uint32_t file = findInclusion(item.string, offset);
+		if (file != UINT32_MAX)
+		{
+			inclusions.push_back({ i, file });
+		}
+		else
+		{
+			offset = addString({ item.string.data, item.string.size }).offset;
+		}
+		item.string.data = reinterpret_cast<const char*>(offset);
+	}
+
+	std::vector<CachedString> names;
+	names.reserve(symbols.size());
+	for (uint32_t i = 0; i < symbols.size(); i++)
+	{
+		names.push_back(addString(symbols.name(i)));
+	}
+
+	std::vector<CachedFile> files;
+	for (const auto& included : arena.files)
+	{
+		files.push_back({ contentHash(included.file->view()), addString(included.path.string()) });
+	}
+
+	if (strings.size() > UINT32_MAX)
+	{
+		return;
+	}
+
+	ParseCacheHeader header{ magic, sourceHash, sourceSize, (uint32_t)instructions.size(), (uint32_t)arena.code.size(), (uint32_t)arena.expressions.size(),
+		(uint32_t)data.size(), (uint32_t)names.size(), (uint32_t)files.size(), (uint32_t)inclusions.size(), (uint32_t)strings.size() };
+
+	std::error_code error;
+	std::filesystem::create_directories(path.parent_path(), error);
+
+	// Written next to the entry and renamed over it, so a concurrent run never maps a partial entry
+	std::filesystem::path temporaryPath = path;
+	temporaryPath += "." + std::to_string(std::random_device()());
+
+	std::ofstream file(temporaryPath, std::ios::binary);
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)instructions.data(), instructions.size() * sizeof(Instruction));
+	file.write((const char*)arena.code.data(), arena.code.size() * sizeof(ExpressionCode));
+	file.write((const char*)arena.expressions.data(), arena.expressions.size() * sizeof(ParseArena::ExpressionRange));
+	file.write((const char*)data.data(), data.size() * sizeof(DataItem));
+	file.write((const char*)names.data(), names.size() * sizeof(CachedString));
+	file.write((const char*)files.data(), files.size() * sizeof(CachedFile));
+	file.write((const char*)inclusions.data(), inclusions.size() * sizeof(CachedInclusion));
+	file.write(strings.data(), strings.size());
+	file.close();
+
+	if (!file)
+	{
+		std::filesystem::remove(temporaryPath, error);
+		return;
+	}
+
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error)
+	{
+		std::filesystem::remove(temporaryPath, error);
+	}
+}
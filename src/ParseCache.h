@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+#include "Instruction.h"
+#include "SymbolTable.h"
+
+// Parses of earlier runs, kept in a directory under the hash of their source. An entry holds the instruction
+// records, expression bytecode, data items and label names as the parser left them, so a hit skips lexing and
+// parsing and code is generated from the mapped entry. Entries are keyed on the assembler build as well, record the files they included and are only used
+// while those still hash the same. The bytes of incbin are not copied into the entry but mapped from those files again
+class ParseCache
+{
+	public:
+		ParseCache(const std::filesystem::path& directory, std::string_view source, uint64_t build);
+
+		bool load(InstructionSpan& instructions, ParseArena& arena, SymbolTable& symbols) const;
+		void store(const std::vector<Instruction>& instructions, const ParseArena& arena, const SymbolTable& symbols) const;
+	private:
+		std::filesystem::path path;
+		uint64_t sourceHash;
+		uint64_t sourceSize;
+};
@@ -5,9 +5,20 @@
 #include "Parser.h"
 #include "Token.h"
 #include "getNumberSize.h"
+#include "instructionsSet.h"
 
-Parser::Parser(std::vector<Token>& tokens):
-tokens(tokens)
+Parser::Parser(const TokenStream& tokens, ParseArena& arena):
+tokens(tokens), arena(arena)
+{
+}
+
+Parser::Parser(SpscQueue<TokenStream>& tokens, ParseArena& arena):
+tokens(tokens), arena(arena)
+{
+}
+
+Parser::Parser(Lexer& lexer, ParseArena& arena):
+tokens(lexer), arena(arena)
 {
 }
 
@@ -21,23 +32,48 @@ std::vector<Instruction>& Parser::parse()
 	return instructions;
 }
 
-const Token& Parser::peek() 
+// Sends the instructions in batches as they are parsed. Each batch takes the arena along, so its indices
+// stay valid on the other side. An empty batch marks the end. Returns the number of instructions
+size_t Parser::parse(SpscQueue<ParseBatch>& queue)
+{
+	size_t instructionCount = 0;
+
+	while (!isEnd())
+	{
+		nextExpression();
+		advance();
+
+		if (instructions.size() >= batchSize || (isEnd() && !instructions.empty()))
+		{
+			instructionCount += instructions.size();
+			queue.push({ std::move(instructions), std::move(arena) });
+			instructions.clear();
+			arena = ParseArena();
+		}
+	}
+
+	queue.push({});
+	return instructionCount;
+}
+
+const SymbolTable& Parser::symbols() const
 {
-	return tokens.at(current);
+	return tokens.symbols();
 }
 
-const Token& Parser::peekNext()
+Token Parser::peek() 
 {
-	if (current + 1 >= tokens.size())
-	{
-		return Token{};
-	} 
-	return tokens.at(current + 1);
+	return tokens.peek();
+}
+
+Token Parser::peekNext()
+{
+	return tokens.peekNext();
 }
 
 void Parser::advance()
 {
-	current++;
+	tokens.advance();
 }
 
 void Parser::nextExpression() 
@@ -59,12 +95,13 @@ void Parser::nextExpression()
 		{
 			if (peekNext().type == TokenType::DATA_DEFINING_INSTRUCTION)
 			{
-				instructions.push_back({ Token { TokenType::DATA_LABEL_DECLARATION, TokenGroup::MAIN, peek().line, 0, 0, peek().stringValue }});
+				instructions.push_back({ TokenType::DATA_LABEL_DECLARATION, 0, 0, 0, peek().line, {} });
 			}
 			else
 			{
-				instructions.push_back({ peek() });
+				instructions.push_back({ peek().type, 0, 0, 0, peek().line, {} });
 			}
+			instructions.back().symbol = (uint32_t)peek().numberValue;
 			break;
 		}
 		case TokenType::DEFINECTCONSTANT_OPERATOR:
@@ -78,7 +115,7 @@ void Parser::nextExpression()
 		}
 		default: 
 		{
-			error(peek().line, "Unexpected token: " + peek().stringValue);
+			error(peek().line, "Unexpected token: " + std::string(peek().stringValue));
 			break;
 		}
 	}
@@ -86,9 +123,7 @@ void Parser::nextExpression()
 
 void Parser::parseInstruction()
 {
-	Token instructionToken = peek();
-
-	std::vector<Node> arguments;
+	Instruction instruction{ TokenType::INSTRUCTION, 0, (uint8_t)peek().numberValue, 0, peek().line, {} };
 
 	if (peekNext().group == TokenGroup::ADDITIONAL) 
 	{
@@ -104,19 +139,19 @@ void Parser::parseInstruction()
 				case TokenType::GETPROGRAMSIZE_OPERATOR:
 				case TokenType::ARITHMETIC_UNARY_OPERATOR:
 				{
-					arguments.push_back(parseArithmeticExpression());
+					addOperand(instruction, parseArithmeticExpression());
 					break;
 				}
 				case TokenType::REGISTER:
 				case TokenType::SEGMENT_REGISTER:
 				{
-					arguments.push_back({ peek(), nullptr, nullptr });
+					addOperand(instruction, peek());
 					break;
 				}
 				case TokenType::LEFT_BRACKET:
 				{
 					advance();
-					arguments.push_back({ Token{ TokenType::MEMORY_ADDRESSING, TokenGroup::ADDITIONAL, peek().line, 1, 0, "" }, nullptr, std::make_shared<Node>(parseMemoryAddressing()) });
+					addOperand(instruction, Token{ TokenType::MEMORY_ADDRESSING, TokenGroup::ADDITIONAL, peek().line, 1, parseMemoryAddressing(), "" });
 					break;
 				}
 				case TokenType::COMMA:
@@ -124,7 +159,7 @@ void Parser::parseInstruction()
 					break;
 				}
 				case TokenType::GETOFFSET_OPERATOR: {
-					arguments.push_back(parseGetoffset());
+					addOperand(instruction, parseGetoffset());
 					break;
 				}
 				case TokenType::LOCAL_LABEL:
@@ -132,17 +167,17 @@ void Parser::parseInstruction()
 				{
 					if (const auto& it = compileTimeConstants.find(peek().stringValue); it != compileTimeConstants.end())
 					{
-						arguments.push_back({ it->second, nullptr, nullptr });
+						addOperand(instruction, it->second);
 					}
 					else
 					{
-						arguments.push_back({ peek(), nullptr, nullptr });
+						addOperand(instruction, peek());
 					}
 					break;
 				}
 				default:
 				{
-					error(peek().line, "Unexpected token: " + peek().stringValue);
+					error(peek().line, "Unexpected token: " + std::string(peek().stringValue));
 				}
 			}
 			if (peekNext().group != TokenGroup::ADDITIONAL)
@@ -153,15 +188,22 @@ void Parser::parseInstruction()
 		}
 	}
 
-	instructions.push_back({ instructionToken, arguments });
+	instructions.push_back(instruction);
 }
 
 void Parser::parseDataDefiningInstruction()
 {
 
-	Token instructionToken = peek();
+	Instruction instruction{ TokenType::DATA_DEFINING_INSTRUCTION, peek().size, (uint8_t)peek().numberValue, 0, peek().line, {} };
+	instruction.data = { arena.dataSize(), 0 };
+	bool isReservation = dataDefiningInstructions[instruction.mnemonic].kind == DataDefinitionKind::RESERVATION;
 
-	std::vector<Node> arguments;
+	if (dataDefiningInstructions[instruction.mnemonic].kind == DataDefinitionKind::INCLUSION)
+	{
+		parseInclusion(instruction);
+		instructions.push_back(instruction);
+		return;
+	}
 
 	if (peekNext().group == TokenGroup::ADDITIONAL)
 	{
@@ -177,8 +219,16 @@ void Parser::parseDataDefiningInstruction()
 				case TokenType::GETPROGRAMSIZE_OPERATOR:
 				case TokenType::ARITHMETIC_UNARY_OPERATOR:
 				{
-					Node expression = parseArithmeticExpression();
-					if (peek().type == TokenType::DUPDATA_OPERATOR) 
+					Token expression = parseArithmeticExpression();
+					if (isReservation && peek().type == TokenType::DUPDATA_OPERATOR)
+					{
+						error(peek().line, "Unexpected token: " + std::string(peek().stringValue));
+					}
+					else if (isReservation)
+					{
+						addReservation(instruction, expression);
+					}
+					else if (peek().type == TokenType::DUPDATA_OPERATOR) 
 					{
 						Token dupOperatorToken = peek();
 						advance();
@@ -191,38 +241,59 @@ void Parser::parseDataDefiningInstruction()
 							case TokenType::GETPROGRAMSIZE_OPERATOR:
 							case TokenType::ARITHMETIC_UNARY_OPERATOR: 
 							{
-								Node secondExpression = parseArithmeticExpression();
-								arguments.push_back(Node{ dupOperatorToken, std::make_shared<Node>(expression), std::make_shared<Node>(secondExpression) });
+								Token secondExpression = parseArithmeticExpression();
+								DataItem item{ TokenType::DUPDATA_OPERATOR, dupOperatorToken.line, {} };
+								item.dup = { toExpression(expression), toExpression(secondExpression) };
+								addDataItem(instruction, item);
 								break;
 							}
 							default:
 							{
-								error(peek().line, "Unexpected token: " + peek().stringValue);
+								error(peek().line, "Unexpected token: " + std::string(peek().stringValue));
 							}
 						}
 					}
 					else 
 					{
-						arguments.push_back(expression);
+						addDataItem(instruction, { expression.type, expression.line, expression.numberValue });
+					}
+					break;
+				}
+				case TokenType::STRING:
+				{
+					if (isReservation)
+					{
+						error(peek().line, "Unexpected token: " + std::string(peek().stringValue));
+					}
+					DataItem item{ TokenType::STRING, peek().line, {} };
+					item.string = { peek().stringValue.data(), (uint32_t)peek().stringValue.size() };
+					addDataItem(instruction, item);
+					if (peekNext().type == TokenType::COMMA)
+					{
+						advance();
 					}
 					break;
 				}
 				case TokenType::LOCAL_LABEL:
 				case TokenType::GLOBAL_LABEL:
 				{
-					if (const auto& it = compileTimeConstants.find(peek().stringValue); it != compileTimeConstants.end())
+					if (const auto& it = compileTimeConstants.find(peek().stringValue); it != compileTimeConstants.end() && isReservation)
+					{
+						addReservation(instruction, it->second);
+					}
+					else if (it != compileTimeConstants.end())
 					{
-						arguments.push_back({ it->second, nullptr, nullptr });
+						addDataItem(instruction, { it->second.type, it->second.line, it->second.numberValue });
 					}
 					else 
 					{
-						error(peek().line, "Unexpected token: " + peek().stringValue);
+						error(peek().line, "Unexpected token: " + std::string(peek().stringValue));
 					}
 					break;
 				}
 				default:
 				{
-					error(peek().line, "Unexpected token: " + peek().stringValue);
+					error(peek().line, "Unexpected token: " + std::string(peek().stringValue));
 				}
 			}
 			if (peekNext().group != TokenGroup::ADDITIONAL)
@@ -233,7 +304,106 @@ void Parser::parseDataDefiningInstruction()
 		}
 	}
 
-	instructions.push_back({ instructionToken, arguments });
+	instructions.push_back(instruction);
+}
+
+void Parser::addOperand(Instruction& instruction, const Token& token)
+{
+	if (instruction.operandCount < 2)
+	{
+		Operand& operand = instruction.operands[instruction.operandCount];
+		operand.type = token.type;
+		operand.size = token.size;
+		if (token.type == TokenType::NUMBER)
+		{
+			// No operand takes more than 16 bits, signed or not
+			if (token.numberValue < INT16_MIN || token.numberValue > UINT16_MAX)
+			{
+				error(token.line, "Operand out of range: " + std::to_string(token.numberValue));
+			}
+			operand.number = (int32_t)token.numberValue;
+		}
+		else
+		{
+			operand.index = (uint32_t)token.numberValue;
+		}
+	}
+	if (instruction.operandCount < UINT8_MAX)
+	{
+		instruction.operandCount++;
+	}
+}
+
+void Parser::addDataItem(Instruction& instruction, const DataItem& item)
+{
+	arena.addData(item);
+	instruction.data.count++;
+}
+
+// incbin 'file'[, offset[, length]] maps the file and passes the bytes on as one string, so they are never tokenized.
+// The file name is relative to the working directory
+void Parser::parseInclusion(Instruction& instruction)
+{
+	uint32_t line = peek().line;
+	std::string directive(peek().stringValue);
+
+	if (peekNext().type != TokenType::STRING)
+	{
+		error(line, directive + ": file name expected");
+	}
+	advance();
+	std::string name(peek().stringValue);
+
+	int64_t bounds[2] = { 0, -1 };
+	size_t boundCount = 0;
+	if (peekNext().type == TokenType::COMMA)
+	{
+		advance();
+	}
+	while (peek().type == TokenType::COMMA && boundCount < std::size(bounds))
+	{
+		advance();
+		Token bound = parseArithmeticExpression();
+		if (bound.type != TokenType::NUMBER || bound.numberValue < 0)
+		{
+			error(line, directive + ": offset and length must be constant and not negative");
+		}
+		bounds[boundCount++] = bound.numberValue;
+	}
+
+	const SourceFile* file = arena.addFile(name);
+	if (!file)
+	{
+		error(line, directive + ": can`t open " + name);
+	}
+
+	std::string_view content = file->view();
+	content = content.substr(std::min<uint64_t>(bounds[0], content.size()), bounds[1] < 0 ? std::string_view::npos : (size_t)bounds[1]);
+	if (content.size() > UINT32_MAX)
+	{
+		error(line, directive + ": file too large");
+	}
+
+	DataItem item{ TokenType::STRING, line, {} };
+	item.string = { content.data(), (uint32_t)content.size() };
+	addDataItem(instruction, item);
+}
+
+// A reserved count is kept as that many zeros, so it is measured like any dup and only the file end tells them apart
+void Parser::addReservation(Instruction& instruction, const Token& count)
+{
+	DataItem item{ TokenType::DUPDATA_OPERATOR, count.line, {} };
+	item.dup = { toExpression(count), toExpression({ TokenType::NUMBER, TokenGroup::ADDITIONAL, count.line, 1, 0, "" }) };
+	addDataItem(instruction, item);
+}
+
+uint32_t Parser::toExpression(const Token& token)
+{
+	if (token.type == TokenType::NUMBER)
+	{
+		return arena.addExpression({ { ExpressionOperation::NUMBER, token.size, token.numberValue } });
+	}
+	return (uint32_t)token.numberValue;
 }
 
 void Parser::parseDefineCompileTimeConstant()
@@ -242,50 +412,54 @@ void Parser::parseDefineCompileTimeConstant()
 
 	if (peek().type != TokenType::LOCAL_LABEL && peek().type != TokenType::GLOBAL_LABEL) 
 	{
-		error(peek().line, "Unexpected token: " + peek().stringValue);
+		error(peek().line, "Unexpected token: " + std::string(peek().stringValue));
 	}
 
-	const std::string& name = peek().stringValue;
+	std::string_view name = peek().stringValue;
 
 	advance();
 
 	if (peek().type != TokenType::EQUAL_OPERATOR)
 	{
-		error(peek().line, "Unexpected token: " + peek().stringValue);
+		error(peek().line, "Unexpected token: " + std::string(peek().stringValue));
 	}
 
 	advance();
 
-	const Token& value = peek();
+	Token value = peek();
 
 	if (value.type != TokenType::NUMBER)
 	{
-		error(peek().line, "Unexpected token: " + value.stringValue);
+		error(peek().line, "Unexpected token: " + std::string(value.stringValue));
 	}
 
 	compileTimeConstants.insert({ name, value });
 }
 
-Node Parser::parseGetoffset()
+Token Parser::parseGetoffset()
 {
-	const Token& ampersandToken = peek();
+	Token ampersandToken = peek();
 
 	advance();
 
 	if (!isEnd() && (peek().type == TokenType::LOCAL_LABEL || peek().type == TokenType::GLOBAL_LABEL)) 
 	{
-		return { ampersandToken, nullptr, std::make_shared<Node>(Node { peek(), nullptr, nullptr }) };
+		ampersandToken.numberValue = peek().numberValue;
+		return ampersandToken;
 	}
 	else 
 	{
-		error(peek().line, "Unexpected token: " + peek().stringValue + " after &");
+		error(peek().line, "Unexpected token: " + std::string(peek().stringValue) + " after &");
 	}
 }
 
-Node Parser::parseArithmeticExpression()
+Token Parser::parseArithmeticExpression()
 {
-	std::stack<Node> output;
 	std::stack<Token> operators;
+	uint32_t line = peek().line;
+
+	expression.clear();
+	expressionDepth = 0;
 
 	while (!isEnd() && peek().group == TokenGroup::ADDITIONAL && peek().type != TokenType::COMMA && peek().type != TokenType::DUPDATA_OPERATOR) {
 		switch (peek().type)
@@ -295,11 +469,11 @@ Node Parser::parseArithmeticExpression()
 			case TokenType::GETCURRENTADDRESS_OPERATOR:
 			case TokenType::GETSTARTADDRESS_OPERATOR:
 			{
-				if (output.size() > 0 && operators.size() < 1)
+				if (expressionDepth > 0 && operators.size() < 1)
 				{
 					error(peek().line, "No operator between operands");
 				}
-				output.push({ peek() });
+				pushOperand(peek());
 				break;
 			}
 			case TokenType::ARITHMETIC_BINARY_OPERATOR:
@@ -311,7 +485,7 @@ Node Parser::parseArithmeticExpression()
 						operators.top().numberValue <= peek().numberValue
 						)
 				{
-					popOperator(output, operators);
+					popOperator(operators);
 				}
 			case TokenType::ARITHMETIC_UNARY_OPERATOR:
 			{
@@ -326,7 +500,7 @@ Node Parser::parseArithmeticExpression()
 						operators.pop();
 						break;
 					}
-					popOperator(output, operators);
+					popOperator(operators);
 					if (operators.size() == 0)
 					{
 						error(peek().line, "Could not find opening parenthesis");
@@ -339,16 +513,16 @@ Node Parser::parseArithmeticExpression()
 			{
 				if (const auto& it = compileTimeConstants.find(peek().stringValue); it != compileTimeConstants.end())
 				{
-					output.push({ it->second, nullptr, nullptr });
+					pushOperand(it->second);
 				}
 				else
 				{
-					error(peek().line, "Unexpected token: " + peek().stringValue);
+					error(peek().line, "Unexpected token: " + std::string(peek().stringValue));
 				}
 				break;
 			}
 			default: {
-				error(peek().line, "Unexpected token: " + peek().stringValue);
+				error(peek().line, "Unexpected token: " + std::string(peek().stringValue));
 			}
 		}
 		if (peekNext().group != TokenGroup::ADDITIONAL)
@@ -360,18 +534,51 @@ Node Parser::parseArithmeticExpression()
 
 	while (operators.size() > 0)
 	{
-		popOperator(output, operators);
+		popOperator(operators);
 	}
 
-	return performArithmeticOperations(output.top());
+	keepLastValue();
+
+	if (expression.size() == 1 && expression.back().operation == ExpressionOperation::NUMBER)
+	{
+		return Token{ TokenType::NUMBER, TokenGroup::ADDITIONAL, line, expression.back().size, expression.back().value, "" };
+	}
+
+	TokenType rootType = TokenType::ARITHMETIC_BINARY_OPERATOR;
+	switch (expression.back().operation)
+	{
+		case ExpressionOperation::CURRENT_ADDRESS:
+		{
+			rootType = TokenType::GETCURRENTADDRESS_OPERATOR;
+			break;
+		}
+		case ExpressionOperation::START_ADDRESS:
+		{
+			rootType = TokenType::GETSTARTADDRESS_OPERATOR;
+			break;
+		}
+		case ExpressionOperation::PROGRAM_SIZE:
+		{
+			rootType = TokenType::GETPROGRAMSIZE_OPERATOR;
+			break;
+		}
+		default:
+		{
+			break;
+		}
+	}
+
+	return Token{ rootType, TokenGroup::ADDITIONAL, line, 0, arena.addExpression(expression), "" };
 }
 
-Node Parser::parseMemoryAddressing()
+uint32_t Parser::parseMemoryAddressing()
 {
-	std::stack<Node> output;
 	std::stack<Token> operators;
 
-	std::unordered_map<std::string, bool> registersUsed = 
+	expression.clear();
+	expressionDepth = 0;
+
+	std::unordered_map<std::string_view, bool> registersUsed = 
 	{
 		{ "bx", false },
 		{ "si", false },
@@ -389,43 +596,43 @@ Node Parser::parseMemoryAddressing()
 			case TokenType::GETCURRENTADDRESS_OPERATOR:
 			case TokenType::GETSTARTADDRESS_OPERATOR:
 			{
-				if (output.size() > 0 && operators.size() < 1) 
+				if (expressionDepth > 0 && operators.size() < 1) 
 				{
 					error(peek().line, "No operator between operands");
 				}
-				if (output.size() > 0 && output.top().token.type == TokenType::REGISTER && operators.top().stringValue == "-")
+				if (expressionDepth > 0 && expression.back().operation == ExpressionOperation::REGISTER && operators.top().stringValue == "-")
 				{
-					output.push(Node{ peek(), nullptr, nullptr });
+					pushOperand(peek());
 					operators.top().stringValue = "+";
-					output.top().token.numberValue *= -1;
+					expression.back().value *= -1;
 				}
 				else 
 				{
-					output.push(Node{ peek(), nullptr, nullptr });
+					pushOperand(peek());
 				}
 				break;
 			}
 			case TokenType::REGISTER:
 			{
-				if (output.size() > 0 && operators.size() < 1)
+				if (expressionDepth > 0 && operators.size() < 1)
 				{
 					error(peek().line, "No operator between operands");
 				}
 				if (const auto &it = registersUsed.find(peek().stringValue); it != registersUsed.end()) 
 				{
-					if (output.size() > 0 && output.top().token.type == TokenType::NUMBER) 
+					if (expressionDepth > 0 && expression.back().operation == ExpressionOperation::NUMBER) 
 					{
 						error(peek().line, "Memory addressing should look like [register + displacement]");
 					}
 					else if (!it->second) 
 					{
-						output.push(Node{ peek(), nullptr, nullptr });
+						pushOperand(peek());
 						it->second = true;
 					}
 				}
 				else
 				{
-					error(peek().line, "Can only use bx, si and di registers. Got: " + peek().stringValue);
+					error(peek().line, "Can only use bx, si and di registers. Got: " + std::string(peek().stringValue));
 				}
 				break;
 			}
@@ -438,12 +645,12 @@ Node Parser::parseMemoryAddressing()
 						operators.top().numberValue <= peek().numberValue
 						)
 				{
-					popOperator(output, operators);
+					popOperator(operators);
 				}
 			case TokenType::ARITHMETIC_UNARY_OPERATOR:
 			{
 				operators.push(peek());
-				if (output.top().token.type == TokenType::REGISTER) 
+				if (expressionDepth > 0 && expression.back().operation == ExpressionOperation::REGISTER) 
 				{
 					operators.top().numberValue = 99;
 				}
@@ -457,7 +664,7 @@ Node Parser::parseMemoryAddressing()
 						operators.pop();
 						break;
 					}
-					popOperator(output, operators);
+					popOperator(operators);
 					if (operators.size() == 0)
 					{
 						error(peek().line, "Could not find opening parenthesis");
@@ -467,7 +674,7 @@ Node Parser::parseMemoryAddressing()
 			}
 			default:
 			{
-				error(peek().line, "Unexpected token: " + peek().stringValue);
+				error(peek().line, "Unexpected token: " + std::string(peek().stringValue));
 			}
 		}
 
@@ -480,115 +687,150 @@ Node Parser::parseMemoryAddressing()
 
 	while (operators.size() > 0)
 	{
-		popOperator(output, operators);
+		popOperator(operators);
 	}
 
-	return performArithmeticOperations(output.top());
+	keepLastValue();
+
+	return arena.addExpression(expression);
 }
 
-void Parser::popOperator(std::stack<Node>& output, std::stack<Token>& operators)
+void Parser::pushOperand(const Token& token)
 {
-	Token op = operators.top();
-	if (op.type == TokenType::LEFT_PAREN) {
-		error(op.line, "Could not find closing parenthesis");
-	}
-	operators.pop();
-
-	Node right;
-	Node left;
-	int64_t result = 0;
-
-	if (output.size() > 0)
+	switch (token.type)
 	{
-		right = output.top();
-		output.pop();
-	}
-	if (output.size() > 0)
-	{
-		left = output.top();
-		output.pop();
+		case TokenType::GETCURRENTADDRESS_OPERATOR:
+		{
+			expression.push_back({ ExpressionOperation::CURRENT_ADDRESS, 0, 0 });
+			break;
+		}
+		case TokenType::GETSTARTADDRESS_OPERATOR:
+		{
+			expression.push_back({ ExpressionOperation::START_ADDRESS, 0, 0 });
+			break;
+		}
+		case TokenType::GETPROGRAMSIZE_OPERATOR:
+		{
+			expression.push_back({ ExpressionOperation::PROGRAM_SIZE, 0, 0 });
+			break;
+		}
+		case TokenType::REGISTER:
+		{
+			expression.push_back({ ExpressionOperation::REGISTER, token.size, token.numberValue });
+			break;
+		}
+		default:
+		{
+			expression.push_back({ ExpressionOperation::NUMBER, token.size, token.numberValue });
+			break;
+		}
 	}
-
-	output.push(Node{ op, std::make_shared<Node>(left), std::make_shared<Node>(right) });
-}
-
-bool Parser::isEnd()
-{
-	return current >= tokens.size() - 1;
+	expressionDepth++;
 }
 
-Node Parser::performArithmeticOperations(Node node, bool registersAsNumbers)
+// Only the value on top of the stack is the result, any values left below it are dropped
+void Parser::keepLastValue()
 {
-	const auto &token = node.token;
-	const auto left = node.left;
-	const auto right = node.right;
+	if (expressionDepth <= 1)
+	{
+		return;
+	}
 
-	if (token.type != TokenType::ARITHMETIC_BINARY_OPERATOR && token.type != TokenType::ARITHMETIC_UNARY_OPERATOR) 
+	size_t first = expression.size();
+	size_t needed = 1;
+	while (needed > 0)
 	{
-		return node;
+		first--;
+		ExpressionOperation operation = expression[first].operation;
+		if (isOperand(operation))
+		{
+			needed--;
+		}
+		else if (!isUnaryOperation(operation))
+		{
+			needed++;
+		}
 	}
-	return performArithmeticOperation(Node{ token, std::make_shared<Node>(performArithmeticOperations(*left, registersAsNumbers)), std::make_shared<Node>(performArithmeticOperations(*right, registersAsNumbers)) }, registersAsNumbers);
+
+	expression.erase(expression.begin(), expression.begin() + first);
+	expressionDepth = 1;
 }
 
-Node Parser::performArithmeticOperation(Node node, bool registersAsNumbers)
+void Parser::popOperator(std::stack<Token>& operators)
 {
-	const auto& op = node.token;
-	const auto left = node.left;
-	const auto right = node.right;
+	Token op = operators.top();
+	if (op.type == TokenType::LEFT_PAREN) {
+		error(op.line, "Could not find closing parenthesis");
+	}
+	operators.pop();
 
-	int64_t result = 0;
+	ExpressionOperation operation = getOperation(op);
+	size_t operands = isUnaryOperation(operation) ? 1 : 2;
 
-	if ((left->token.type != TokenType::NONE && left->token.type != TokenType::NUMBER && !(registersAsNumbers && left->token.type == TokenType::REGISTER)) || (right->token.type != TokenType::NONE && right->token.type != TokenType::NUMBER && !(registersAsNumbers && right->token.type == TokenType::REGISTER)))
+	// A missing operand counts as zero, so "[-4]" reads as "0 - 4"
+	while (expressionDepth < operands)
 	{
-		return node;
+		expression.insert(expression.begin(), { ExpressionOperation::NUMBER, 0, 0 });
+		expressionDepth++;
 	}
-	if (op.type == TokenType::ARITHMETIC_UNARY_OPERATOR) 
+	expressionDepth -= operands - 1;
+
+	// Constant operands are always the last codes emitted, so they are folded in place
+	size_t first = expression.size() - operands;
+	if (expression[first].operation == ExpressionOperation::NUMBER && expression.back().operation == ExpressionOperation::NUMBER)
 	{
-		if (op.stringValue == "+") 
+		int64_t result = 0;
+		if (ExpressionError arithmeticError = applyOperation(operation, expression[first].value, expression.back().value, result); arithmeticError != ExpressionError::NONE)
 		{
-			result = right->token.numberValue;
-		}
-		else if (op.stringValue == "-") 
-		{
-			result = right->token.numberValue * -1;
+			error(op.line, expressionErrorMessage(arithmeticError));
 		}
+		expression.resize(first);
+		expression.push_back({ ExpressionOperation::NUMBER, getNumberSize(result), result });
 	}
-	else 
+	else
+	{
+		expression.push_back({ operation, 0, 0 });
+	}
+}
+
+ExpressionOperation Parser::getOperation(const Token& op)
+{
+	if (op.type == TokenType::ARITHMETIC_UNARY_OPERATOR)
 	{
-		if (op.stringValue == "+")
+		return op.stringValue == "-" ? ExpressionOperation::NEGATE : ExpressionOperation::PLUS;
+	}
+
+	switch (op.stringValue[0])
+	{
+		case '-':
 		{
-			result = left->token.numberValue + right->token.numberValue;
+			return ExpressionOperation::SUBTRACT;
 		}
-		else if (op.stringValue == "-")
+		case '*':
 		{
-			result = left->token.numberValue - right->token.numberValue;
+			return ExpressionOperation::MULTIPLY;
 		}
-		else if (op.stringValue == "*")
+		case '/':
 		{
-			result = left->token.numberValue * right->token.numberValue;
+			return ExpressionOperation::DIVIDE;
 		}
-		else if (op.stringValue == "/")
+		case '^':
 		{
-			result = left->token.numberValue / right->token.numberValue;
+			return ExpressionOperation::POWER;
 		}
-		else if(op.stringValue == "^") 
+		default:
 		{
-			result = 1;
-			for (int i = 0; i < abs(right->token.numberValue); i++) 
-			{
-				result *= left->token.numberValue;
-			}
-			if (right->token.numberValue < 0) 
-			{
-				result = 1 / result;
-			}
+			return ExpressionOperation::ADD;
 		}
 	}
+}
 
-	return Node{ Token { TokenType::NUMBER, TokenGroup::ADDITIONAL, op.line, getNumberSize(result), result, ""} };
+bool Parser::isEnd()
+{
+	return tokens.isEnd();
 }
 
-void Parser::error(uint16_t line, const std::string& message)
+void Parser::error(uint32_t line, const std::string& message)
 {
 	std::cout << "Line " << line << ": " << message << '\n';
 	exit(-1);	
@@ -1,46 +1,65 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <stack>
 #include <memory>
 #include <map>
 
 #include "Token.h"
+#include "TokenStream.h"
+#include "TokenReader.h"
+#include "SpscQueue.h"
 #include "Instruction.h"
 
 class Parser
 {
 	public:
-		Parser(std::vector<Token> &tokens);
+		Parser(const TokenStream& tokens, ParseArena& arena);
+		Parser(SpscQueue<TokenStream>& tokens, ParseArena& arena);
+		Parser(Lexer& lexer, ParseArena& arena);
 		std::vector<Instruction>& parse();
+		size_t parse(SpscQueue<ParseBatch>& queue);
 
-		static Node performArithmeticOperations(Node node, bool registersAsNumbers = false);
-		static Node performArithmeticOperation(Node node, bool registersAsNumbers = false);
+		const SymbolTable& symbols() const;
 	private:
-		std::vector<Token>&tokens;
+		static constexpr size_t batchSize = 4096;
 
-		std::map<std::string, const Token&> compileTimeConstants;
+		TokenReader tokens;
+		ParseArena& arena;
+
+		std::map<std::string_view, Token> compileTimeConstants;
 
 		std::vector<Instruction> instructions;
 
-		uint16_t current = 0;   
+		std::vector<ExpressionCode> expression;
+		size_t expressionDepth = 0;
 
-		const Token& peek();
-		const Token& peekNext();
+		Token peek();
+		Token peekNext();
 		void advance();
 		void nextExpression();
 		void parseInstruction();
 		void parseDataDefiningInstruction();
 		void parseDefineCompileTimeConstant();
 
-		Node parseGetoffset();
+		void addOperand(Instruction& instruction, const Token& token);
+		void addDataItem(Instruction& instruction, const DataItem& item);
+		void addReservation(Instruction& instruction, const Token& count);
+		void parseInclusion(Instruction& instruction);
+		uint32_t toExpression(const Token& token);
+
+		Token parseGetoffset();
 
-		Node parseMemoryAddressing();
-		Node parseArithmeticExpression();
-		void popOperator(std::stack<Node>& output, std::stack<Token>& operators);
+		uint32_t parseMemoryAddressing();
+		Token parseArithmeticExpression();
+		void pushOperand(const Token& token);
+		void popOperator(std::stack<Token>& operators);
+		void keepLastValue();
+		static ExpressionOperation getOperation(const Token& op);
 
 		bool isEnd();
 
-		static void error(uint16_t line, const std::string& message);
+		static void error(uint32_t line, const std::string& message);
 };
\ No newline at end of file
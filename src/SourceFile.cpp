@@ -0,0 +1,160 @@
+#include <fstream>
+
+#include "SourceFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+SourceFile::SourceFile(const std::filesystem::path& path, bool isCopyOnWrite)
+{
+	opened = map(path, isCopyOnWrite) || read(path);
+}
+
+SourceFile::~SourceFile()
+{
+	unmap();
+}
+
+bool SourceFile::isOpen() const
+{
+	return opened;
+}
+
+std::string_view SourceFile::view() const
+{
+	return { data, size };
+}
+
+// Only copy-on-write files may be written through this
+char* SourceFile::writableData() const
+{
+	return data;
+}
+
+#ifdef _WIN32
+
+bool SourceFile::map(const std::filesystem::path& path, bool isCopyOnWrite)
+{
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, isCopyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, isCopyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+	if (!view)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	mappingHandle = mapping;
+	data = static_cast<char*>(view);
+	size = (size_t)fileSize.QuadPart;
+	mapped = true;
+	return true;
+}
+
+void SourceFile::unmap()
+{
+	if (!mapped)
+	{
+		return;
+	}
+	UnmapViewOfFile(data);
+	CloseHandle(mappingHandle);
+	CloseHandle(fileHandle);
+	mapped = false;
+}
+
+#else
+
+bool SourceFile::map(const std::filesystem::path& path, bool isCopyOnWrite)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode) || fileStat.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, (size_t)fileStat.st_size, isCopyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+
+	madvise(view, (size_t)fileStat.st_size, MADV_SEQUENTIAL);
+
+	data = static_cast<char*>(view);
+	size = (size_t)fileStat.st_size;
+	mapped = true;
+	return true;
+}
+
+void SourceFile::unmap()
+{
+	if (!mapped)
+	{
+		return;
+	}
+	munmap(data, size);
+	mapped = false;
+}
+
+#endif
+
+bool SourceFile::read(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	std::streamoff fileSize = file.tellg();
+	if (fileSize > 0)
+	{
+		buffer.resize((size_t)fileSize);
+		file.seekg(0);
+		file.read(buffer.data(), fileSize);
+		buffer.resize((size_t)file.gcount());
+	}
+
+	data = buffer.data();
+	size = buffer.size();
+	return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <filesystem>
+
+class SourceFile
+{
+	public:
+		// A copy-on-write file can be changed in memory without changing it on disk
+		SourceFile(const std::filesystem::path& path, bool isCopyOnWrite = false);
+		~SourceFile();
+
+		SourceFile(const SourceFile&) = delete;
+		SourceFile& operator=(const SourceFile&) = delete;
+
+		bool isOpen() const;
+		std::string_view view() const;
+		char* writableData() const;
+	private:
+		char* data = nullptr;
+		size_t size = 0;
+		bool opened = false;
+		bool mapped = false;
+
+		std::string buffer;
+
+#ifdef _WIN32
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#endif
+
+		bool map(const std::filesystem::path& path, bool isCopyOnWrite);
+		bool read(const std::filesystem::path& path);
+		void unmap();
+};
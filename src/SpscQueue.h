@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Bounded ring between one producer and one consumer thread. push waits while the ring is full
+// and pop while it is empty, so a fast stage can never run further ahead than the capacity
+template <typename T>
+class SpscQueue
+{
+	public:
+		explicit SpscQueue(size_t capacity)
+		{
+			size_t size = 1;
+			while (size < capacity)
+			{
+				size <<= 1;
+			}
+			slots.resize(size);
+			mask = size - 1;
+		}
+
+		void push(T&& item)
+		{
+			size_t position = tail.load(std::memory_order_relaxed);
+			while (position - head.load(std::memory_order_acquire) > mask)
+			{
+				std::this_thread::yield();
+			}
+			slots[position & mask] = std::move(item);
+			tail.store(position + 1, std::memory_order_release);
+		}
+
+		T pop()
+		{
+			size_t position = head.load(std::memory_order_relaxed);
+			while (tail.load(std::memory_order_acquire) == position)
+			{
+				std::this_thread::yield();
+			}
+			T item = std::move(slots[position & mask]);
+			slots[position & mask] = T();
+			head.store(position + 1, std::memory_order_release);
+			return item;
+		}
+	private:
+		std::vector<T> slots;
+		size_t mask = 0;
+
+		alignas(64) std::atomic<size_t> head = 0;
+		alignas(64) std::atomic<size_t> tail = 0;
+};
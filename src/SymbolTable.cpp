@@ -0,0 +1,28 @@
+#include <utility>
+
+#include "SymbolTable.h"
+
+SymbolTable::SymbolTable(std::vector<std::string_view> names)
+:names(std::move(names))
+{
+}
+
+uint32_t SymbolTable::intern(std::string_view name)
+{
+	auto [it, inserted] = ids.try_emplace(name, (uint32_t)names.size());
+	if (inserted)
+	{
+		names.push_back(name);
+	}
+	return it->second;
+}
+
+std::string_view SymbolTable::name(uint32_t id) const
+{
+	return names[id];
+}
+
+size_t SymbolTable::size() const
+{
+	return names.size();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Gives every label name a dense id in order of first appearance
+class SymbolTable
+{
+	public:
+		SymbolTable() = default;
+		// Names ids without interning them, for tables nothing is interned into later
+		explicit SymbolTable(std::vector<std::string_view> names);
+
+		uint32_t intern(std::string_view name);
+		std::string_view name(uint32_t id) const;
+		size_t size() const;
+	private:
+		std::unordered_map<std::string_view, uint32_t> ids;
+		std::vector<std::string_view> names;
+};
@@ -1,8 +1,9 @@
 #pragma once
 
-#include <iostream>
+#include <cstdint>
+#include <string_view>
 
-enum class TokenType
+enum class TokenType : uint8_t
 {
 	NONE,
 
@@ -10,6 +11,7 @@ enum class TokenType
 	DATA_DEFINING_INSTRUCTION,
 
 	NUMBER,
+	STRING,
 	LOCAL_LABEL,
 	GLOBAL_LABEL,
 	LOCAL_LABEL_DECLARATION,
@@ -40,7 +42,7 @@ enum class TokenType
 	END_OF_FILE,
 };
 
-enum class TokenGroup 
+enum class TokenGroup : uint8_t
 {
 	MAIN,
 	ADDITIONAL,
@@ -50,9 +52,9 @@ struct Token
 {
 	TokenType type = TokenType::NONE;
 	TokenGroup group;
-	uint16_t line;
+	uint32_t line;
 	uint8_t size;
 	int64_t numberValue;
-	std::string stringValue;
+	std::string_view stringValue;
 };
 
@@ -0,0 +1,131 @@
+#include "TokenReader.h"
+
+TokenReader::TokenReader(const TokenStream& tokens):
+chunk(&tokens)
+{
+}
+
+// Waits for the first chunk, so the lexer thread has to be running already
+TokenReader::TokenReader(SpscQueue<TokenStream>& queue):
+queue(&queue), chunk(&currentChunk)
+{
+	currentChunk = queue.pop();
+	currentSymbolIds = internSymbols(currentChunk);
+}
+
+TokenReader::TokenReader(Lexer& lexer):
+lexer(&lexer)
+{
+	lookahead[0] = lexer.next();
+	if (lookahead[0].type != TokenType::END_OF_FILE)
+	{
+		lookahead[1] = lexer.next();
+	}
+}
+
+Token TokenReader::peek()
+{
+	if (lexer)
+	{
+		return lookahead[lookaheadFirst];
+	}
+	if (current < chunk->size())
+	{
+		return get(*chunk, currentSymbolIds, current);
+	}
+	return Token{};
+}
+
+Token TokenReader::peekNext()
+{
+	if (lexer)
+	{
+		return lookahead[lookaheadFirst ^ 1];
+	}
+	if (current + 1 < chunk->size())
+	{
+		return get(*chunk, currentSymbolIds, current + 1);
+	}
+	if (current + 1 == chunk->size() && receiveNextChunk())
+	{
+		return get(nextChunk, nextSymbolIds, 0);
+	}
+	return Token{};
+}
+
+void TokenReader::advance()
+{
+	if (lexer)
+	{
+		bool isLast = lookahead[lookaheadFirst ^ 1].type == TokenType::END_OF_FILE || lookahead[lookaheadFirst ^ 1].type == TokenType::NONE;
+		lookahead[lookaheadFirst] = isLast ? Token{} : lexer->next();
+		lookaheadFirst ^= 1;
+		return;
+	}
+	current++;
+	if (current >= chunk->size() && receiveNextChunk())
+	{
+		current -= chunk->size();
+		currentChunk = std::move(nextChunk);
+		currentSymbolIds = std::move(nextSymbolIds);
+		hasNextChunk = false;
+	}
+}
+
+bool TokenReader::isEnd()
+{
+	if (lexer)
+	{
+		return lookahead[lookaheadFirst].type == TokenType::END_OF_FILE || lookahead[lookaheadFirst].type == TokenType::NONE;
+	}
+	return isFinalChunk() && current >= chunk->size() - 1;
+}
+
+const SymbolTable& TokenReader::symbols() const
+{
+	if (lexer)
+	{
+		return lexer->symbols();
+	}
+	return queue ? symbolTable : chunk->symbols();
+}
+
+bool TokenReader::isFinalChunk() const
+{
+	return !queue || chunk->type(chunk->size() - 1) == TokenType::END_OF_FILE;
+}
+
+bool TokenReader::receiveNextChunk()
+{
+	if (isFinalChunk())
+	{
+		return false;
+	}
+	if (!hasNextChunk)
+	{
+		nextChunk = queue->pop();
+		nextSymbolIds = internSymbols(nextChunk);
+		hasNextChunk = true;
+	}
+	return true;
+}
+
+std::vector<uint32_t> TokenReader::internSymbols(const TokenStream& tokens)
+{
+	std::vector<uint32_t> symbolIds(tokens.symbols().size());
+	for (uint32_t id = 0; id < symbolIds.size(); id++)
+	{
+		symbolIds[id] = symbolTable.intern(tokens.symbols().name(id));
+	}
+	return symbolIds;
+}
+
+Token TokenReader::get(const TokenStream& tokens, const std::vector<uint32_t>& symbolIds, size_t index)
+{
+	Token token = tokens[index];
+	if (!symbolIds.empty() && TokenStream::isSymbol(token.type))
+	{
+		token.numberValue = symbolIds[token.numberValue];
+	}
+	return token;
+}
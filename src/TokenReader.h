@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Token.h"
+#include "TokenStream.h"
+#include "SymbolTable.h"
+#include "SpscQueue.h"
+#include "Lexer.h"
+
+// Walks a whole token stream, the chunks a lexer thread sends through a queue, or tokens pulled from a lexer one
+// at a time. Chunks carry their own symbol tables, so their label ids are mapped into one table owned by the reader
+class TokenReader
+{
+	public:
+		explicit TokenReader(const TokenStream& tokens);
+		explicit TokenReader(SpscQueue<TokenStream>& queue);
+		explicit TokenReader(Lexer& lexer);
+
+		Token peek();
+		Token peekNext();
+		void advance();
+		bool isEnd();
+
+		const SymbolTable& symbols() const;
+	private:
+		SpscQueue<TokenStream>* queue = nullptr;
+		const TokenStream* chunk = nullptr;
+
+		// The parser looks at most one token ahead, so pulled tokens live in a ring of two
+		Lexer* lexer = nullptr;
+		std::array<Token, 2> lookahead;
+		size_t lookaheadFirst = 0;
+
+		TokenStream currentChunk;
+		TokenStream nextChunk;
+		std::vector<uint32_t> currentSymbolIds;
+		std::vector<uint32_t> nextSymbolIds;
+		bool hasNextChunk = false;
+
+		SymbolTable symbolTable;
+
+		size_t current = 0;
+
+		bool isFinalChunk() const;
+		bool receiveNextChunk();
+		std::vector<uint32_t> internSymbols(const TokenStream& tokens);
+		static Token get(const TokenStream& tokens, const std::vector<uint32_t>& symbolIds, size_t index);
+};
@@ -0,0 +1,264 @@
+#include <array>
+#include <iterator>
+
+#include "TokenStream.h"
+#include "registers.h"
+#include "instructionsSet.h"
+
+static constexpr std::array<char, 256> makeCharacters()
+{
+	std::array<char, 256> result{};
+	for (size_t i = 0; i < result.size(); i++)
+	{
+		result[i] = (char)i;
+	}
+	return result;
+}
+
+static constexpr std::array<char, 256> characters = makeCharacters();
+
+static int64_t operatorPrecedence(char c)
+{
+	switch (c)
+	{
+		case '^':
+			return 0;
+		case '*':
+		case '/':
+			return 1;
+		default:
+			return 2;
+	}
+}
+
+void TokenStream::push(const Token& token)
+{
+	uint32_t payload = 0;
+
+	switch (token.type)
+	{
+		case TokenType::NUMBER:
+		{
+			payload = (uint32_t)numbers.size();
+			numbers.push_back({ token.numberValue, token.stringValue });
+			break;
+		}
+		case TokenType::INSTRUCTION:
+		{
+			payload = (uint32_t)token.numberValue;
+			break;
+		}
+		case TokenType::DATA_DEFINING_INSTRUCTION:
+		{
+			payload = (uint32_t)token.numberValue;
+			break;
+		}
+		case TokenType::REGISTER:
+		{
+			payload = (uint32_t)token.numberValue + (token.size == 2 ? 8 : 0);
+			break;
+		}
+		case TokenType::SEGMENT_REGISTER:
+		{
+			payload = (uint32_t)token.numberValue;
+			break;
+		}
+		case TokenType::STRING:
+		{
+			payload = (uint32_t)strings.size();
+			strings.push_back(token.stringValue);
+			break;
+		}
+		case TokenType::END_OF_FILE:
+		{
+			break;
+		}
+		default:
+		{
+			if (isSymbol(token.type))
+			{
+				payload = (uint32_t)token.numberValue;
+			}
+			else
+			{
+				payload = (uint8_t)token.stringValue[0];
+			}
+			break;
+		}
+	}
+
+	types.push_back(token.type);
+	groups.push_back(token.group);
+	lines.push_back(token.line);
+	sizes.push_back(token.size);
+	payloads.push_back(payload);
+}
+
+void TokenStream::append(const TokenStream& other)
+{
+	size_t first = types.size();
+	uint32_t numbersOffset = (uint32_t)numbers.size();
+	uint32_t stringsOffset = (uint32_t)strings.size();
+
+	std::vector<uint32_t> symbolIds(other.symbolTable.size());
+	for (uint32_t id = 0; id < symbolIds.size(); id++)
+	{
+		symbolIds[id] = symbolTable.intern(other.symbolTable.name(id));
+	}
+
+	types.insert(types.end(), other.types.begin(), other.types.end());
+	groups.insert(groups.end(), other.groups.begin(), other.groups.end());
+	lines.insert(lines.end(), other.lines.begin(), other.lines.end());
+	sizes.insert(sizes.end(), other.sizes.begin(), other.sizes.end());
+	payloads.insert(payloads.end(), other.payloads.begin(), other.payloads.end());
+	numbers.insert(numbers.end(), other.numbers.begin(), other.numbers.end());
+	strings.insert(strings.end(), other.strings.begin(), other.strings.end());
+
+	for (size_t i = first; i < types.size(); i++)
+	{
+		if (types[i] == TokenType::NUMBER)
+		{
+			payloads[i] += numbersOffset;
+		}
+		else if (types[i] == TokenType::STRING)
+		{
+			payloads[i] += stringsOffset;
+		}
+		else if (isSymbol(types[i]))
+		{
+			payloads[i] = symbolIds[payloads[i]];
+		}
+	}
+}
+
+void TokenStream::reserve(size_t count)
+{
+	types.reserve(count);
+	groups.reserve(count);
+	lines.reserve(count);
+	sizes.reserve(count);
+	payloads.reserve(count);
+}
+
+// Drops the tokens but keeps the symbol table, so ids handed out earlier stay valid
+void TokenStream::clear()
+{
+	types.clear();
+	groups.clear();
+	lines.clear();
+	sizes.clear();
+	payloads.clear();
+	numbers.clear();
+	strings.clear();
+}
+
+Token TokenStream::operator[](size_t index) const
+{
+	Token token{ types[index], groups[index], lines[index], sizes[index], 0, {} };
+	uint32_t payload = payloads[index];
+
+	switch (token.type)
+	{
+		case TokenType::NUMBER:
+		{
+			token.numberValue = numbers[payload].value;
+			token.stringValue = numbers[payload].text;
+			break;
+		}
+		case TokenType::INSTRUCTION:
+		{
+			token.numberValue = payload;
+			token.stringValue = mnemonics[payload];
+			break;
+		}
+		case TokenType::DATA_DEFINING_INSTRUCTION:
+		{
+			token.numberValue = payload;
+			token.stringValue = dataDefiningInstructions[payload].name;
+			break;
+		}
+		case TokenType::REGISTER:
+		{
+			token.numberValue = registers[payload].index;
+			token.stringValue = registers[payload].name;
+			break;
+		}
+		case TokenType::SEGMENT_REGISTER:
+		{
+			token.numberValue = segmentRegisters[payload].index;
+			token.stringValue = segmentRegisters[payload].name;
+			break;
+		}
+		case TokenType::GETSTARTADDRESS_OPERATOR:
+		{
+			token.stringValue = "$$";
+			break;
+		}
+		case TokenType::END_OF_FILE:
+		{
+			token.stringValue = "EOF";
+			break;
+		}
+		case TokenType::ARITHMETIC_BINARY_OPERATOR:
+		{
+			token.numberValue = operatorPrecedence((char)payload);
+			token.stringValue = { &characters[payload], 1 };
+			break;
+		}
+		case TokenType::STRING:
+		{
+			token.stringValue = strings[payload];
+			break;
+		}
+		default:
+		{
+			if (isSymbol(token.type))
+			{
+				token.numberValue = payload;
+				token.stringValue = symbolTable.name(payload);
+			}
+			else
+			{
+				token.stringValue = { &characters[payload], 1 };
+			}
+			break;
+		}
+	}
+
+	return token;
+}
+
+TokenType TokenStream::type(size_t index) const
+{
+	return types[index];
+}
+
+void TokenStream::setType(size_t index, TokenType type)
+{
+	types[index] = type;
+}
+
+size_t TokenStream::size() const
+{
+	return types.size();
+}
+
+bool TokenStream::empty() const
+{
+	return types.empty();
+}
+
+SymbolTable& TokenStream::symbols()
+{
+	return symbolTable;
+}
+
+const SymbolTable& TokenStream::symbols() const
+{
+	return symbolTable;
+}
+
+bool TokenStream::isSymbol(TokenType type)
+{
+	return type == TokenType::LOCAL_LABEL || type == TokenType::GLOBAL_LABEL || type == TokenType::LOCAL_LABEL_DECLARATION || type == TokenType::GLOBAL_LABEL_DECLARATION || type == TokenType::DATA_LABEL_DECLARATION;
+}
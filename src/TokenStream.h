@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "Token.h"
+#include "SymbolTable.h"
+
+// Tokens stored as parallel arrays. Numbers and strings live in side pools, labels carry their
+// symbol id; keyword and punctuation tokens are fully described by their payload.
+class TokenStream
+{
+	public:
+		void push(const Token& token);
+		void append(const TokenStream& other);
+		void reserve(size_t count);
+		void clear();
+
+		Token operator[](size_t index) const;
+		TokenType type(size_t index) const;
+		void setType(size_t index, TokenType type);
+
+		size_t size() const;
+		bool empty() const;
+
+		SymbolTable& symbols();
+		const SymbolTable& symbols() const;
+
+		static bool isSymbol(TokenType type);
+	private:
+		struct Number
+		{
+			int64_t value;
+			std::string_view text;
+		};
+
+		std::vector<TokenType> types;
+		std::vector<TokenGroup> groups;
+		std::vector<uint32_t> lines;
+		std::vector<uint8_t> sizes;
+		std::vector<uint32_t> payloads;
+
+		std::vector<Number> numbers;
+		std::vector<std::string_view> strings;
+		SymbolTable symbolTable;
+};
@@ -0,0 +1,40 @@
+#include <filesystem>
+
+#include "buildIdentity.h"
+#include "SourceFile.h"
+#include "contentHash.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+static std::filesystem::path getExecutablePath()
+{
+#ifdef _WIN32
+	wchar_t path[MAX_PATH];
+	DWORD length = GetModuleFileNameW(nullptr, path, MAX_PATH);
+	return length > 0 && length < MAX_PATH ? std::filesystem::path(path) : std::filesystem::path();
+#else
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::read_symlink("/proc/self/exe", error);
+	return error ? std::filesystem::path() : path;
+#endif
+}
+
+std::optional<uint64_t> buildIdentity()
+{
+	std::filesystem::path path = getExecutablePath();
+	if (path.empty())
+	{
+		return std::nullopt;
+	}
+
+	SourceFile executable(path);
+	if (!executable.isOpen() || executable.view().empty())
+	{
+		return std::nullopt;
+	}
+	return contentHash(executable.view());
+}
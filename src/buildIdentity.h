@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+// Hash of the running assembler executable, so results cached by one build are never used by another.
+// Empty when the executable can't be found or read
+std::optional<uint64_t> buildIdentity();
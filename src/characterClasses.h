@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+enum CharacterClass : uint8_t
+{
+	DIGIT = 1 << 0,
+	BINARY_DIGIT = 1 << 1,
+	OCTAL_DIGIT = 1 << 2,
+	HEX_DIGIT = 1 << 3,
+	ALPHA = 1 << 4,
+	WHITESPACE = 1 << 5,
+};
+
+constexpr std::array<uint8_t, 256> makeCharacterClasses()
+{
+	std::array<uint8_t, 256> classes{};
+
+	for (int c = '0'; c <= '9'; c++)
+	{
+		classes[c] |= DIGIT | HEX_DIGIT;
+	}
+	for (int c = '0'; c <= '1'; c++)
+	{
+		classes[c] |= BINARY_DIGIT;
+	}
+	for (int c = '0'; c <= '8'; c++)
+	{
+		classes[c] |= OCTAL_DIGIT;
+	}
+	for (int c = 'a'; c <= 'z'; c++)
+	{
+		classes[c] |= ALPHA;
+		classes[c - 'a' + 'A'] |= ALPHA;
+	}
+	for (int c = 'a'; c <= 'f'; c++)
+	{
+		classes[c] |= HEX_DIGIT;
+		classes[c - 'a' + 'A'] |= HEX_DIGIT;
+	}
+	classes['_'] |= ALPHA;
+
+	classes[' '] |= WHITESPACE;
+	classes['\t'] |= WHITESPACE;
+	classes['\r'] |= WHITESPACE;
+
+	return classes;
+}
+
+inline constexpr std::array<uint8_t, 256> characterClasses = makeCharacterClasses();
+
+constexpr bool hasCharacterClass(char c, uint8_t mask)
+{
+	return (characterClasses[(uint8_t)c] & mask) != 0;
+}
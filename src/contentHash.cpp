@@ -0,0 +1,101 @@
+#include <cstring>
+
+#include "contentHash.h"
+
+static constexpr uint64_t prime1 = 11400714785074694791ull;
+static constexpr uint64_t prime2 = 14029467366897019727ull;
+static constexpr uint64_t prime3 = 1609587929392839161ull;
+static constexpr uint64_t prime4 = 9650029242287828579ull;
+static constexpr uint64_t prime5 = 2870177450012600261ull;
+
+static uint64_t rotateLeft(uint64_t value, int count)
+{
+	return (value << count) | (value >> (64 - count));
+}
+
+static uint64_t read64(const char* data)
+{
+	uint64_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static uint32_t read32(const char* data)
+{
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static uint64_t round(uint64_t accumulator, uint64_t input)
+{
+	return rotateLeft(accumulator + input * prime2, 31) * prime1;
+}
+
+static uint64_t mergeRound(uint64_t hash, uint64_t accumulator)
+{
+	return (hash ^ round(0, accumulator)) * prime1 + prime4;
+}
+
+uint64_t contentHash(std::string_view data, uint64_t seed)
+{
+	const char* p = data.data();
+	const char* end = p + data.size();
+	uint64_t hash;
+
+	if (data.size() >= 32)
+	{
+		uint64_t accumulators[4] = { seed + prime1 + prime2, seed + prime2, seed, seed - prime1 };
+		for (; end - p >= 32; p += 32)
+		{
+			for (int lane = 0; lane < 4; lane++)
+			{
+				accumulators[lane] = round(accumulators[lane], read64(p + lane * 8));
+			}
+		}
+
+		hash = rotateLeft(accumulators[0], 1) + rotateLeft(accumulators[1], 7) + rotateLeft(accumulators[2], 12) + rotateLeft(accumulators[3], 18);
+		for (uint64_t accumulator : accumulators)
+		{
+			hash = mergeRound(hash, accumulator);
+		}
+	}
+	else
+	{
+		hash = seed + prime5;
+	}
+
+	hash += data.size();
+
+	for (; end - p >= 8; p += 8)
+	{
+		hash = rotateLeft(hash ^ round(0, read64(p)), 27) * prime1 + prime4;
+	}
+	if (end - p >= 4)
+	{
+		hash = rotateLeft(hash ^ read32(p) * prime1, 23) * prime2 + prime3;
+		p += 4;
+	}
+	for (; p < end; p++)
+	{
+		hash = rotateLeft(hash ^ (uint8_t)*p * prime5, 11) * prime1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= prime2;
+	hash ^= hash >> 29;
+	hash *= prime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+std::string hashToHex(uint64_t hash)
+{
+	static constexpr char digits[] = "0123456789abcdef";
+	std::string hex(16, '0');
+	for (size_t i = hex.size(); i-- > 0; hash >>= 4)
+	{
+		hex[i] = digits[hash & 0xF];
+	}
+	return hex;
+}
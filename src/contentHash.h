@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// 64-bit xxHash of data. Fast enough to key caches on whole files, not meant to resist deliberate collisions
+uint64_t contentHash(std::string_view data, uint64_t seed = 0);
+
+// 16 lowercase hex digits, for naming files after a hash
+std::string hashToHex(uint64_t hash);
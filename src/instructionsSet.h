@@ -1,29 +1,97 @@
 #pragma once
 
-#include <string>
-#include <map>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
 
-struct InstructionInfo 
+enum class OperandClass : uint8_t
 {
-	std::string operands[2];
-	uint8_t operandsSizes[2];
+	NONE,
+	G, // general purpose register
+	S, // segment register
+	M, // memory
+	I, // immediate
+	J, // relative jump target
+
+	AL, CL, DL, BL, AH, CH, DH, BH,
+	AX, CX, DX, BX, SP, BP, SI, DI,
+	CS, DS, SS, ES,
 };
 
+constexpr OperandClass getRegisterOperandClass(uint8_t size, uint8_t index)
+{
+	return (OperandClass)((uint8_t)OperandClass::AL + (size == 2 ? 8 : 0) + index);
+}
+
+constexpr OperandClass getSegmentRegisterOperandClass(uint8_t index)
+{
+	return (OperandClass)((uint8_t)OperandClass::CS + index);
+}
+
 struct Opcode 
 {
 	uint8_t opcode;
-	uint8_t opcodeExtension;
+	uint8_t opcodeExtension = 0;
+};
 
-	bool operator<(const Opcode& other) const noexcept
-	{
-		return opcode < other.opcode;
-	}
+// A reservation takes counts of uninitialized items, which are zeros in the file unless nothing but
+// reservations follows them. An inclusion takes a file name and an optional offset and length
+enum class DataDefinitionKind : uint8_t
+{
+	VALUES,
+	RESERVATION,
+	INCLUSION,
 };
 
-extern const std::map<std::string, uint8_t> dataDefiningInstructions;
+struct DataDefiningInstruction
+{
+	std::string_view name;
+	uint8_t size;
+	DataDefinitionKind kind = DataDefinitionKind::VALUES;
+};
 
-extern const std::map<std::string, const std::multimap<Opcode, InstructionInfo>> instructions;
+constexpr DataDefiningInstruction dataDefiningInstructions[] = {
+	{ "db", 1 },  // 1 byte
+	{ "dw", 2 },  // word : 2 bytes
+	{ "dd", 4 },  // double word:  4 bytes
+	{ "dq", 8 },  // quad word: 8 bytes
+	{ "resb", 1, DataDefinitionKind::RESERVATION },
+	{ "resw", 2, DataDefinitionKind::RESERVATION },
+	{ "resd", 4, DataDefinitionKind::RESERVATION },
+	{ "resq", 8, DataDefinitionKind::RESERVATION },
+	{ "incbin", 1, DataDefinitionKind::INCLUSION },
+};
+
+constexpr std::string_view mnemonics[] = {
+	"org", "ret", "mov", "int", "jmp", "jmp_short", "add", "adc",
+	"push", "pop", "and", "xor", "inc", "jo", "jno", "jb",
+	"jnb", "jz", "jnz", "jbe", "ja", "test", "xchg", "nop",
+	"movsb", "movsw", "cmpsb", "cmpsw", "les", "lds", "aam", "aad",
+	"xlat", "loopnz", "loopz", "loop", "jcxz", "in", "out", "lock",
+	"repnz", "repz", "hlt", "cmc", "or", "sbb", "sub", "cmp",
+	"dec", "js", "jns", "jpe", "jpo", "jl", "jge", "jle",
+	"jg", "lea", "cbw", "cwd", "call", "wait", "pushf", "popf",
+	"sahf", "lahf", "stosb", "stosw", "lodsb", "lodsw", "scasb", "scasw",
+	"retf", "into", "iret", "clc", "stc", "cli", "sti", "cld",
+	"std", "rol", "ror", "rcl", "rcr", "shl", "shr", "sar",
+	"not", "neg", "mul", "imul", "div", "idiv", "use_es", "use_ss",
+	"use_cs", "use_ds",
+};
+
+constexpr uint8_t findMnemonic(std::string_view name)
+{
+	uint8_t id = 0;
+	while (id < std::size(mnemonics) && mnemonics[id] != name)
+	{
+		id++;
+	}
+	return id;
+}
 
-bool checkInstuction(std::string instruction);
+constexpr uint8_t orgMnemonic = findMnemonic("org");
+constexpr uint8_t jmpMnemonic = findMnemonic("jmp");
+constexpr uint8_t jmpShortMnemonic = findMnemonic("jmp_short");
 
-std::pair<int8_t, int8_t> getInstructionOpcode(const std::string& instruction, const std::string& operandA, const std::string operandB, uint8_t *sizeA, uint8_t *sizeB, bool isSizeAIdentical = false, bool isSizeBIdentical = false);
\ No newline at end of file
+const Opcode* getInstructionOpcode(uint8_t mnemonic, OperandClass operandA, OperandClass operandB, uint8_t *sizeA, uint8_t *sizeB);
+// Only the encoding with exactly these operand sizes, for picking among forms that do the same
+const Opcode* getExactInstructionOpcode(uint8_t mnemonic, OperandClass operandA, OperandClass operandB, uint8_t sizeA, uint8_t sizeB);
\ No newline at end of file
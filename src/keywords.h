@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+#include "registers.h"
+#include "instructionsSet.h"
+
+enum class KeywordType : uint8_t
+{
+	NONE,
+	REGISTER,
+	SEGMENT_REGISTER,
+	DATA_DEFINING_INSTRUCTION,
+	INSTRUCTION,
+};
+
+struct Keyword
+{
+	std::string_view name;
+	KeywordType type;
+	uint8_t size;
+	uint8_t index; // register index, dataDefiningInstructions index or mnemonic id
+};
+
+constexpr size_t keywordCount = std::size(registers) + std::size(segmentRegisters) + std::size(dataDefiningInstructions) + std::size(mnemonics);
+constexpr size_t keywordTableSize = 4096;
+
+static_assert(keywordCount < 0xFF, "Keyword slots are stored as uint8_t");
+
+constexpr char foldCase(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? c | 0x20 : c;
+}
+
+constexpr uint32_t keywordHash(std::string_view s, uint32_t seed)
+{
+	uint32_t hash = seed ^ (uint32_t)s.size();
+	for (char c : s)
+	{
+		hash = (hash ^ (uint8_t)foldCase(c)) * 16777619u;
+	}
+	return hash ^ (hash >> 16);
+}
+
+constexpr std::array<Keyword, keywordCount> makeKeywords()
+{
+	std::array<Keyword, keywordCount> result{};
+	size_t i = 0;
+
+	for (const auto& r : registers)
+	{
+		result[i++] = { r.name, KeywordType::REGISTER, r.size, r.index };
+	}
+	for (const auto& r : segmentRegisters)
+	{
+		result[i++] = { r.name, KeywordType::SEGMENT_REGISTER, r.size, r.index };
+	}
+	for (size_t d = 0; d < std::size(dataDefiningInstructions); d++)
+	{
+		result[i++] = { dataDefiningInstructions[d].name, KeywordType::DATA_DEFINING_INSTRUCTION, dataDefiningInstructions[d].size, (uint8_t)d };
+	}
+	for (size_t m = 0; m < std::size(mnemonics); m++)
+	{
+		result[i++] = { mnemonics[m], KeywordType::INSTRUCTION, 0, (uint8_t)m };
+	}
+
+	return result;
+}
+
+inline constexpr std::array<Keyword, keywordCount> keywords = makeKeywords();
+
+constexpr size_t maxKeywordLength()
+{
+	size_t length = 0;
+	for (const auto& keyword : keywords)
+	{
+		length = keyword.name.size() > length ? keyword.name.size() : length;
+	}
+	return length;
+}
+
+struct KeywordTable
+{
+	uint32_t seed;
+	std::array<uint8_t, keywordTableSize> slots; // keyword index + 1, 0 = empty
+};
+
+// Searches for a seed that maps every keyword to its own slot, so a lookup is a single probe
+constexpr KeywordTable makeKeywordTable()
+{
+	KeywordTable table{};
+
+	for (uint32_t seed = 1; seed < 1000; seed++)
+	{
+		for (auto& slot : table.slots)
+		{
+			slot = 0;
+		}
+
+		bool collision = false;
+		for (size_t i = 0; i < keywords.size() && !collision; i++)
+		{
+			uint8_t& slot = table.slots[keywordHash(keywords[i].name, seed) & (keywordTableSize - 1)];
+			collision = slot != 0;
+			slot = (uint8_t)(i + 1);
+		}
+
+		if (!collision)
+		{
+			table.seed = seed;
+			return table;
+		}
+	}
+
+	return table;
+}
+
+inline constexpr KeywordTable keywordTable = makeKeywordTable();
+
+static_assert(keywordTable.seed != 0, "No collision-free keyword hash seed found");
+
+constexpr const Keyword* findKeyword(std::string_view identifier)
+{
+	if (identifier.size() > maxKeywordLength())
+	{
+		return nullptr;
+	}
+
+	uint8_t slot = keywordTable.slots[keywordHash(identifier, keywordTable.seed) & (keywordTableSize - 1)];
+	if (slot == 0)
+	{
+		return nullptr;
+	}
+
+	const Keyword& keyword = keywords[slot - 1];
+	if (keyword.name.size() != identifier.size())
+	{
+		return nullptr;
+	}
+	for (size_t i = 0; i < identifier.size(); i++)
+	{
+		if (foldCase(identifier[i]) != keyword.name[i])
+		{
+			return nullptr;
+		}
+	}
+
+	return &keyword;
+}
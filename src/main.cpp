@@ -2,56 +2,234 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
-#include <sstream>
+#include <string_view>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+#include <optional>
 
+#include "SourceFile.h"
 #include "Lexer.h"
 #include "Parser.h"
 #include "CodeGenerator.h"
+#include "ParseCache.h"
+#include "OutputCache.h"
+#include "buildIdentity.h"
+#include "SpscQueue.h"
+#include "writeSparse.h"
+
+static constexpr size_t queueDepth = 8;
+
+static constexpr std::string_view usage =
+	"Usage: assembler [-j threads] [-p | -s] [-O] [-c cache directory] source\n"
+	"  -j  threads for lexing and code generation, all cores by default\n"
+	"  -p  lexer, parser and code generator run as a pipeline of one thread each, so -j has no effect.\n"
+	"      Neither does -c, since jumps to later batches are encoded near and the whole parse is never in memory at once\n"
+	"  -s  the parser pulls tokens straight from the lexer\n"
+	"  -O  pick the shortest encoding of every instruction\n"
+	"  -c  keep parses and outputs in the cache directory and reuse them for unchanged sources\n";
+
+static int writeOutput(const std::filesystem::path& path, const std::vector<uint8_t>& output)
+{
+	std::ofstream outputFile(path, std::ios::binary);
+
+	if (!outputFile.is_open())
+	{
+		std::cout << "Can`t create or open output file" << '\n';
+		return -1;
+	}
+
+	if (!writeSparse(outputFile, path, { (const char*)output.data(), output.size() }))
+	{
+		std::cout << "Can`t write output file" << '\n';
+		return -1;
+	}
+	return 0;
+}
+
+// Only outputs that were written out completely and assembled without diagnostics are cached, a hit would
+// not repeat those
+static int writeOutput(const std::filesystem::path& path, const CodeGenerator& codeGenerator, const std::vector<uint8_t>& output, const ParseArena& arena, const std::optional<OutputCache>& outputCache)
+{
+	int result = writeOutput(path, output);
+	if (result == 0 && !codeGenerator.hasLabelsNotFound() && outputCache)
+	{
+		outputCache->store(path, arena);
+	}
+	return result;
+}
 
 int main(int argc, char **argv) 
 {
 	std::ios::sync_with_stdio(false);
 
-	if (argc < 2) {
-		std::cout << "Program path not specified" << '\n';
+	std::filesystem::path path;
+	unsigned threadCount = std::thread::hardware_concurrency();
+	bool hasThreadCount = false;
+	bool pipelined = false;
+	bool streamed = false;
+	bool optimizesSize = false;
+	std::filesystem::path cacheDirectory;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string_view argument = argv[i];
+
+		if (argument == "-j" && i + 1 < argc)
+		{
+			threadCount = std::max(std::atoi(argv[++i]), 1);
+			hasThreadCount = true;
+		}
+		else if (argument == "-p")
+		{
+			pipelined = true;
+		}
+		else if (argument == "-s")
+		{
+			streamed = true;
+		}
+		else if (argument == "-O")
+		{
+			optimizesSize = true;
+		}
+		else if (argument == "-c" && i + 1 < argc)
+		{
+			cacheDirectory = argv[++i];
+		}
+		else
+		{
+			path = argument;
+		}
+	}
+
+	if (path.empty()) {
+		std::cout << "Program path not specified" << '\n' << usage;
 		return -1;
 	}
 
-	std::filesystem::path path = argv[1];
+	if (pipelined && hasThreadCount)
+	{
+		std::cout << "-j has no effect with -p, every stage runs on one thread" << '\n';
+	}
+	if (pipelined && !cacheDirectory.empty())
+	{
+		std::cout << "-c has no effect with -p, its output can differ from the cached one" << '\n';
+		cacheDirectory.clear();
+	}
 
-	std::ifstream inputFile(path);
-	std::stringstream ss;
+	SourceFile inputFile(path);
 
-	if (!inputFile.is_open())
+	if (!inputFile.isOpen())
 	{
 		std::cout << "Invalid path specified" << '\n';
 		return -1;
 	}
 
-	ss << inputFile.rdbuf();
-	inputFile.close();
+	// Cached results are only used by the build that made them
+	std::optional<uint64_t> build;
+	if (!cacheDirectory.empty())
+	{
+		build = buildIdentity();
+		if (!build)
+		{
+			std::cout << "Can`t read the assembler executable, the cache is not used" << '\n';
+		}
+	}
 
-	Lexer lexer(ss.str());
-	std::vector<Token>& tokens = lexer.tokenize();
+	std::optional<OutputCache> outputCache;
+	std::optional<ParseCache> parseCache;
+	if (build)
+	{
+		outputCache.emplace(cacheDirectory, inputFile.view(), *build, optimizesSize);
+		if (outputCache->load(path.replace_extension("bin")))
+		{
+			std::cout << "Got the output from the cache" << '\n';
+			return 0;
+		}
+
+		parseCache.emplace(cacheDirectory, inputFile.view(), *build);
+
+		ParseArena arena;
+		SymbolTable symbols;
+		InstructionSpan cachedInstructions;
+		if (parseCache->load(cachedInstructions, arena, symbols))
+		{
+			std::cout << "Got " << cachedInstructions.size() << " instructions from the parse cache" << '\n';
+
+			CodeGenerator codeGenerator(cachedInstructions, arena, symbols, threadCount, optimizesSize);
+
+			std::vector<uint8_t>& output = codeGenerator.generate();
+			return writeOutput(path.replace_extension("bin"), codeGenerator, output, arena, outputCache);
+		}
+	}
+
+	Lexer lexer(inputFile.view());
+
+	if (pipelined)
+	{
+		// Lexer and parser run on their own threads, code is generated here as batches arrive
+		SpscQueue<TokenStream> tokenQueue(queueDepth);
+		SpscQueue<ParseBatch> batchQueue(queueDepth);
+
+		size_t tokenCount = 0;
+		std::thread lexerThread([&] { tokenCount = lexer.tokenize(tokenQueue); });
+
+		ParseArena arena;
+		Parser parser(tokenQueue, arena);
+
+		size_t instructionCount = 0;
+		std::thread parserThread([&] { instructionCount = parser.parse(batchQueue); });
+
+		CodeGenerator codeGenerator(parser.symbols(), optimizesSize);
+		std::vector<uint8_t>& output = codeGenerator.generate(batchQueue);
+
+		lexerThread.join();
+		parserThread.join();
+
+		std::cout << "Got " << tokenCount << " tokens" << '\n';
+		std::cout << "Got " << instructionCount << " instructions" << '\n';
+
+		return writeOutput(path.replace_extension("bin"), output);
+	}
+
+	if (streamed)
+	{
+		// The parser pulls tokens straight from the lexer, so no token stream is built
+		ParseArena arena;
+		Parser parser(lexer, arena);
+		std::vector<Instruction>& parsedInstructions = parser.parse();
+
+		std::cout << "Got " << lexer.tokenCount() << " tokens" << '\n';
+		std::cout << "Got " << parsedInstructions.size() << " instructions" << '\n';
+
+		if (parseCache)
+		{
+			parseCache->store(parsedInstructions, arena, parser.symbols());
+		}
+
+		CodeGenerator codeGenerator(parsedInstructions, arena, parser.symbols(), threadCount, optimizesSize);
+
+		std::vector<uint8_t>& output = codeGenerator.generate();
+		return writeOutput(path.replace_extension("bin"), codeGenerator, output, arena, outputCache);
+	}
+
+	TokenStream& tokens = lexer.tokenize(threadCount);
 
 	std::cout << "Got " << tokens.size() - 1 << " tokens" << '\n';
 
-	Parser parser(tokens);
+	ParseArena arena;
+	Parser parser(tokens, arena);
 	std::vector<Instruction>& parsedInstructions = parser.parse();
 
 	std::cout << "Got " << parsedInstructions.size() << " instructions" << '\n';
 
-	CodeGenerator codeGenerator(parsedInstructions);
-
-	std::ofstream outputFile(path.replace_extension("bin"), std::ios::binary);
-
-	if (!outputFile.is_open())
+	if (parseCache)
 	{
-		std::cout << "Can`t create or open output file" << '\n';
-		return -1;
+		parseCache->store(parsedInstructions, arena, tokens.symbols());
 	}
 
-	outputFile << codeGenerator.generate().rdbuf();
+	CodeGenerator codeGenerator(parsedInstructions, arena, tokens.symbols(), threadCount, optimizesSize);
 
-	outputFile.close();
+	std::vector<uint8_t>& output = codeGenerator.generate();
+	return writeOutput(path.replace_extension("bin"), codeGenerator, output, arena, outputCache);
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Runs function(i) for every i in [0, count) on up to threadCount threads, the calling thread included
+template <typename Function>
+void parallelFor(size_t count, unsigned threadCount, Function function)
+{
+	std::atomic<size_t> next = 0;
+
+	auto worker = [&]()
+	{
+		for (size_t i = next++; i < count; i = next++)
+		{
+			function(i);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < std::min<size_t>(threadCount, count); i++)
+	{
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+}
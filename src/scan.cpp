@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "scan.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCAN_SSE2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+struct ScanImplementation
+{
+	const char* (*findNewline)(const char*, const char*);
+	size_t (*countNewlines)(const char*, const char*);
+};
+
+static const char* findNewlineScalar(const char* begin, const char* end)
+{
+	const void* found = begin < end ? memchr(begin, '\n', end - begin) : nullptr;
+	return found ? static_cast<const char*>(found) : end;
+}
+
+static size_t countNewlinesScalar(const char* begin, const char* end)
+{
+	return begin < end ? (size_t)std::count(begin, end, '\n') : 0;
+}
+
+#ifdef SCAN_SSE2
+
+static unsigned countTrailingZeros(uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+static const char* findNewlineSse2(const char* begin, const char* end)
+{
+	const __m128i newline = _mm_set1_epi8('\n');
+
+	while (end - begin >= 16)
+	{
+		__m128i chunk = _mm_loadu_si128((const __m128i*)begin);
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+		if (mask != 0)
+		{
+			return begin + countTrailingZeros(mask);
+		}
+		begin += 16;
+	}
+
+	return findNewlineScalar(begin, end);
+}
+
+// Matches are accumulated in per-byte counters, which are folded with SAD before they can overflow
+static size_t countNewlinesSse2(const char* begin, const char* end)
+{
+	const __m128i newline = _mm_set1_epi8('\n');
+	size_t count = 0;
+
+	while (end - begin >= 16)
+	{
+		__m128i counters = _mm_setzero_si128();
+		for (int i = 0; i < 255 && end - begin >= 16; i++, begin += 16)
+		{
+			__m128i chunk = _mm_loadu_si128((const __m128i*)begin);
+			counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(chunk, newline));
+		}
+		__m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+		count += (size_t)_mm_cvtsi128_si32(sums) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+	}
+
+	return count + countNewlinesScalar(begin, end);
+}
+
+TARGET_AVX2 static const char* findNewlineAvx2(const char* begin, const char* end)
+{
+	const __m256i newline = _mm256_set1_epi8('\n');
+
+	while (end - begin >= 32)
+	{
+		__m256i chunk = _mm256_loadu_si256((const __m256i*)begin);
+		uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline));
+		if (mask != 0)
+		{
+			return begin + countTrailingZeros(mask);
+		}
+		begin += 32;
+	}
+
+	return findNewlineSse2(begin, end);
+}
+
+TARGET_AVX2 static size_t countNewlinesAvx2(const char* begin, const char* end)
+{
+	const __m256i newline = _mm256_set1_epi8('\n');
+	size_t count = 0;
+
+	while (end - begin >= 32)
+	{
+		__m256i counters = _mm256_setzero_si256();
+		for (int i = 0; i < 255 && end - begin >= 32; i++, begin += 32)
+		{
+			__m256i chunk = _mm256_loadu_si256((const __m256i*)begin);
+			counters = _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(chunk, newline));
+		}
+		__m256i sums = _mm256_sad_epu8(counters, _mm256_setzero_si256());
+		__m128i halves = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+		count += (size_t)_mm_cvtsi128_si32(halves) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(halves, 8));
+	}
+
+	return count + countNewlinesSse2(begin, end);
+}
+
+static bool hasAvx2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+	__cpuid(info, 1);
+	bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+	__cpuidex(info, 7, 0);
+	return osSavesYmm && (info[1] & (1 << 5));
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+static ScanImplementation selectImplementation()
+{
+#ifdef SCAN_SSE2
+	if (hasAvx2())
+	{
+		return { findNewlineAvx2, countNewlinesAvx2 };
+	}
+	return { findNewlineSse2, countNewlinesSse2 };
+#else
+	return { findNewlineScalar, countNewlinesScalar };
+#endif
+}
+
+static const ScanImplementation& implementation()
+{
+	static const ScanImplementation selected = selectImplementation();
+	return selected;
+}
+
+const char* findNewline(const char* begin, const char* end)
+{
+	return implementation().findNewline(begin, end);
+}
+
+size_t countNewlines(const char* begin, const char* end)
+{
+	return implementation().countNewlines(begin, end);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+
+// Returns a pointer to the first '\n' in [begin, end), or end if there is none
+const char* findNewline(const char* begin, const char* end);
+
+size_t countNewlines(const char* begin, const char* end);
@@ -0,0 +1,31 @@
+#include <algorithm>
+
+#include "writeSparse.h"
+
+static constexpr size_t sparseBlockSize = 4096;
+
+static bool isZeroBlock(const char* begin, const char* end)
+{
+	return std::all_of(begin, end, [](char byte) { return byte == 0; });
+}
+
+bool writeSparse(std::ofstream& file, const std::filesystem::path& path, std::string_view data)
+{
+	size_t written = 0;
+	for (size_t block = 0; block < data.size(); block += sparseBlockSize)
+	{
+		size_t end = std::min(block + sparseBlockSize, data.size());
+		if (isZeroBlock(data.data() + block, data.data() + end))
+		{
+			file.write(data.data() + written, block - written);
+			file.seekp(end);
+			written = end;
+		}
+	}
+	file.write(data.data() + written, data.size() - written);
+	file.close();
+
+	std::error_code error;
+	std::filesystem::resize_file(path, data.size(), error);
+	return file && !error;
+}
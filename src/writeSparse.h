@@ -0,0 +1,9 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+
+// Writes data to file, opened on path, and closes it. Zero blocks are seeked over instead of written and the
+// length is set at the end, so file systems that support it keep them as holes
+bool writeSparse(std::ofstream& file, const std::filesystem::path& path, std::string_view data);